@@ -0,0 +1,129 @@
+/** @file
+ *  @brief Static analysis of the parsed state machine model.
+ */
+
+#pragma once
+
+#include "reader.hpp"
+#include <map>
+#include <string>
+#include <vector>
+
+///\brief A transition that can never be taken, together with the reason.
+struct DeadTransition
+{
+    ///\brief Index of the transition, as used by Reader::getTransition.
+    size_t      index;
+    std::string reason;
+
+    DeadTransition() : index(), reason() {}
+    ~DeadTransition() = default;
+};
+
+///\brief How the generated code finds the transition to take for the active state.
+enum class DispatchBackend
+{
+    ///\brief One react function per state, calling the react function of its parent.
+    Recursive,
+    ///\brief One react function per state, holding the transitions of all its parents.
+    Flat,
+    ///\brief Constant tables indexed by state and event, without any react function.
+    Table,
+};
+
+///\brief Steps done by the generated code to handle an event, each field is an upper bound.
+struct ExecutionCost
+{
+    ///\brief Nested calls below the top run cycle, react functions followed by an action.
+    size_t depth;
+
+    ///\brief React functions called, one for the active state and one for each parent it reaches.
+    size_t reacts;
+
+    ///\brief Guards evaluated on transitions and choices.
+    size_t guards;
+
+    ///\brief Comparisons of the active state needed to find the exit actions, only done by the recursive backend.
+    size_t checks;
+    size_t exits;
+    size_t entries;
+
+    ///\brief Sum of all steps of the most expensive single path.
+    size_t total;
+
+    ExecutionCost() : depth(), reacts(), guards(), checks(), exits(), entries(), total() {}
+    ~ExecutionCost() = default;
+};
+
+class Analyzer
+{
+private:
+    Reader&                     reader;
+    bool                        parent_first_execution;
+    DispatchBackend             backend;
+    std::vector<StateId>        reachable_states;
+    std::vector<StateId>        active_states;
+    std::vector<std::string>    raised_events;
+    std::vector<DeadTransition> dead_transitions;
+
+    void        enter_state(State* state, std::vector<StateId>& visited_choices);
+    void        mark_reachable(StateId id);
+    void        collect_raised_events();
+    std::string get_dead_reason(Transition* tr);
+    std::string describe(const Transition* tr);
+    bool        is_event_used(const Event* event);
+    bool        is_leaf_state(const State* state);
+    std::string get_signature(const State* state, const std::map<StateId, size_t>& blocks);
+    std::string get_event_key(const Transition* tr);
+    size_t      remove_unused_time_events();
+    static bool contains(const std::vector<StateId>& ids, StateId id);
+
+    bool                has_entry_action(StateId id);
+    bool                has_exit_action(StateId id);
+    std::vector<State*> get_child_states(const State* state);
+    void                collect_exit_branches(State* state, StateId top, std::vector<StateId>& leaves);
+    ExecutionCost       get_worst_cost(State* active, const std::string& event);
+    ExecutionCost       get_exit_cost(State* active, State* source);
+    ExecutionCost       get_entry_cost(State* target, std::vector<StateId> visited_choices);
+    static void         add_path(ExecutionCost& worst, ExecutionCost path);
+
+public:
+    Analyzer(Reader& reader, bool parent_first_execution, DispatchBackend backend);
+    ~Analyzer() = default;
+
+    ///\brief Finds reachable states, dead transitions and events that are never raised.
+    void analyze();
+
+    ///\brief Prints a warning for each unreachable state, dead transition and unused event.
+    void report();
+
+    ///\brief Removes everything reported as dead from the model, and analyzes the result again.
+    void eliminate_dead_code();
+
+    ///\brief Merges leaf states with equal parent, actions and transitions, and reports each merge.
+    void minimize();
+
+    ///\brief Prints the worst case cost of each event in each active state, most expensive first.
+    void report_wcet();
+
+    ///\brief True if the state can be entered from the initial state.
+    bool is_reachable(StateId id) const;
+
+    ///\brief True if the state is a possible resting state of the machine.
+    bool is_active(StateId id) const;
+
+    ///\brief True for the initial and final pseudo states.
+    static bool is_pseudo_state(const State* state);
+
+    ///\brief States entered when entering the given state, following any initial sub-states.
+    std::vector<State*> get_entry_path(State* state);
+
+    ///\brief The given state followed by all of its parents, outermost last.
+    std::vector<State*> get_ancestors(State* state);
+
+    ///\brief Transitions taken from a choice in the order they are evaluated, the default last.
+    std::vector<Transition*> get_choice_branches(State* choice);
+
+    ///\brief First event raised by a declaration, matching what the writer emits, or empty.
+    static std::string get_raised_event(const std::string& declaration);
+};
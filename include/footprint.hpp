@@ -0,0 +1,78 @@
+/** @file
+ *  @brief Writes a JSON report of the memory footprint and code shape of a generated state machine.
+ */
+
+#pragma once
+
+#include "reader.hpp"
+#include "writer.hpp"
+#include <ostream>
+#include <string>
+#include <vector>
+
+///\brief Size and alignment of a generated type, estimated for a 64 bit target.
+struct TypeLayout
+{
+    size_t size;
+    size_t align;
+
+    ///\brief False if any member has a type without a builtin size.
+    bool is_known;
+
+    TypeLayout() : size(), align(1), is_known(true) {}
+    ~TypeLayout() = default;
+};
+
+///\brief Lines and branches of a single generated react function.
+struct FunctionShape
+{
+    std::string              name;
+    std::vector<std::string> states;
+    size_t                   lines;
+    size_t                   branches;
+
+    ///\brief Longest if / else if chain in the function.
+    size_t max_chain;
+
+    FunctionShape() : name(), states(), lines(), branches(), max_chain() {}
+    ~FunctionShape() = default;
+};
+
+class Footprint
+{
+private:
+    Reader&                    reader;
+    const WriterConfig&        config;
+    size_t                     queue_capacity;
+    std::vector<FunctionShape> functions;
+
+    static TypeLayout get_builtin_layout(const std::string& type);
+    static TypeLayout get_struct_layout(const std::vector<TypeLayout>& members);
+    static TypeLayout get_union_layout(const std::vector<TypeLayout>& members);
+    TypeLayout        get_enum_layout(size_t count) const;
+    static TypeLayout get_array_layout(const TypeLayout& item, size_t count);
+
+    TypeLayout get_event_data_layout();
+    TypeLayout get_event_layout();
+    TypeLayout get_out_event_data_layout();
+    TypeLayout get_out_event_layout();
+    TypeLayout get_time_events_layout();
+    TypeLayout get_variables_layout();
+    TypeLayout get_queue_layout(const TypeLayout& item) const;
+    TypeLayout get_ingress_layout();
+    TypeLayout get_machine_layout();
+    size_t     get_max_react_depth();
+
+    static void write_size(std::ostream& out, const std::string& name, const TypeLayout& layout, bool is_last);
+
+public:
+    ///\brief The queue capacity is the one used by the generated code, 0 if the queues are unbounded.
+    Footprint(Reader& reader, const WriterConfig& config, size_t queue_capacity);
+    ~Footprint() = default;
+
+    ///\brief Adds a generated react function, with the states that call it and the body as written.
+    void add_function(const std::string& name, const std::vector<std::string>& states, const std::string& body);
+
+    ///\brief Writes the report to the given file, returns false on failure.
+    bool generate(const std::string& path);
+};
@@ -0,0 +1,36 @@
+/** @file
+ *  @brief Profile recorded by an instrumented state machine, used to optimize the generated code.
+ */
+
+#pragma once
+
+#include "reader.hpp"
+#include <map>
+#include <string>
+
+class Profile
+{
+private:
+    std::map<std::string, size_t> states;
+    std::map<std::string, size_t> transitions;
+    bool                          is_loaded;
+
+public:
+    Profile();
+    ~Profile() = default;
+
+    ///\brief Reads a profile as returned by get_profile() of an instrumented machine, returns false on failure.
+    bool load(const std::string& filename);
+
+    ///\brief True if a profile has been loaded.
+    bool has_data() const;
+
+    ///\brief Number of events dispatched while the state was active.
+    size_t get_state_count(const std::string& name) const;
+
+    ///\brief Number of times the transition was taken.
+    size_t get_transition_count(const std::string& key) const;
+
+    ///\brief Name of the transition in the profile, stable as long as the transition is not changed.
+    static std::string get_transition_key(Reader& reader, const Transition* tr);
+};
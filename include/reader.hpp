@@ -98,6 +98,25 @@ struct Import
     ~Import() = default;
 };
 
+///\brief What a fixed capacity event queue does with an event raised while it is full.
+enum class QueueOverflow
+{
+    Assert,
+    DropNewest,
+    DropOldest,
+    ReturnFalse,
+};
+
+///\brief A state whose content is read from another diagram.
+struct Submachine
+{
+    std::string state;
+    std::string filename;
+
+    Submachine() : state(), filename() {}
+    ~Submachine() = default;
+};
+
 class Reader
 {
   private:
@@ -111,8 +130,19 @@ class Reader
     std::vector<Variable>         variables;
     std::vector<Import>           imports;
     std::vector<std::string>      uml;
+    std::vector<Submachine>       submachines;
+    std::string                   directory;
+    size_t                        nesting;
+    size_t                        queue_capacity;
+    QueueOverflow                 queue_overflow;
+
+    Reader(const std::string& filename, bool v, size_t depth);
 
     void                            collect_states();
+    void                            inline_submachine(const Submachine& submachine);
+    static std::string              rename_variables(const std::string&           str,
+                                                     const std::vector<Variable>& vars,
+                                                     const std::string&           prefix);
     static std::vector<std::string> tokenize(const std::string& str);
     StateId                         add_state(State state);
     Event                           add_event(const Event& event);
@@ -129,6 +159,13 @@ class Reader
 
     std::string get_model_name() const;
 
+    ///\brief Capacity of the event queues set in the header, 0 if the queues are unbounded.
+    size_t        get_queue_capacity() const;
+    QueueOverflow get_queue_overflow() const;
+
+    ///\brief Parses an overflow policy name, returns false if the name is unknown.
+    static bool parse_queue_overflow(const std::string& str, QueueOverflow& overflow);
+
     size_t      get_uml_line_count() const;
     std::string get_uml_line(size_t i) const;
 
@@ -162,9 +199,21 @@ class Reader
 
     Event* findEvent(const std::string& name);
 
+    size_t      getTransitionCount() const;
+    Transition* getTransition(size_t id);
+
     size_t      getTransitionCountFromStateId(StateId id) const;
     Transition* getTransitionFrom(StateId id, size_t tr);
 
     size_t            getDeclCount(StateId stateId, Declaration type) const;
     StateDeclaration* getDeclFromStateId(StateId state_id, Declaration type, size_t id);
+
+    ///\brief Removes the state and all of its declarations, transitions are left untouched.
+    void remove_state(StateId id);
+
+    ///\brief Removes the transition with index id, as used by getTransition.
+    void remove_transition(size_t id);
+
+    ///\brief Removes the event with the given name.
+    void remove_event(const std::string& name);
 };
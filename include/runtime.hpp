@@ -0,0 +1,31 @@
+/** @file
+ *  @brief Writes the runtime support header shared by all generated state machines.
+ */
+
+#pragma once
+
+#include <fstream>
+#include <string>
+
+class Runtime
+{
+private:
+    static void write_timers(std::ofstream& out);
+    static void write_timer_service(std::ofstream& out);
+    static void write_queues(std::ofstream& out);
+    static void write_tracing(std::ofstream& out);
+    static void write_trace_ring(std::ofstream& out);
+
+public:
+    ///\brief Version of the runtime header, bump on any incompatible change.
+    static constexpr unsigned int version = 5;
+
+    ///\brief Name of the generated runtime header.
+    static std::string get_filename();
+
+    ///\brief Namespace used for all runtime types.
+    static std::string get_namespace();
+
+    ///\brief Writes the runtime header to the output directory, returns false on failure.
+    static bool generate(const std::string& outdir);
+};
@@ -25,6 +25,7 @@ public:
     std::string get_state_run_cycle(const State* state);
     std::string get_state_entry(const State* state);
     std::string get_state_exit(const State* state);
+    std::string get_state_choice(const State* state);
     std::string get_state_name(const State* state);
     std::string get_state_name_pure(const State* state);
     static std::string get_state_type();
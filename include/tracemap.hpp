@@ -0,0 +1,39 @@
+/** @file
+ *  @brief Symbol map naming the ids of the binary trace records of a generated state machine.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+class TraceMap
+{
+private:
+    std::string                                     model;
+    std::map<std::string, std::vector<std::string>> names;
+
+public:
+    TraceMap();
+    ~TraceMap() = default;
+
+    ///\brief Id stored in the trace records of a model, a 16 bit fold of the FNV-1a hash of its name.
+    static uint16_t get_model_id(const std::string& model);
+
+    void               set_model(const std::string& name);
+    const std::string& get_model() const;
+
+    ///\brief Appends a name to the list of the kind (state, event, transition or timer), its id is its position.
+    void add(const std::string& kind, const std::string& name);
+
+    ///\brief Name of the id in the list of the kind, or the id itself if the map does not know it.
+    std::string get_name(const std::string& kind, size_t id) const;
+
+    ///\brief Writes the map to the given file, returns false on failure.
+    bool generate(const std::string& path) const;
+
+    ///\brief Reads a map written by generate(), returns false on failure.
+    bool load(const std::string& path);
+};
@@ -4,9 +4,28 @@
 
 #pragma once
 
+#include "profile.hpp"
 #include "reader.hpp"
 #include "style.hpp"
 #include <fstream>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+///\brief How the generated machine calls the tracing hooks on state entry and exit.
+enum class TraceHook
+{
+    ///\brief A std::function for entry and one for exit, set at run time.
+    Function,
+
+    ///\brief A plain function pointer and a context pointer for entry and for exit, set at run time.
+    Pointer,
+
+    ///\brief The static enter() and exit() of the type named by PLANTGEN_TRACER, called directly so they inline.
+    Static,
+};
 
 ///\brief Configuration for the code generator.
 struct WriterConfig
@@ -23,10 +42,190 @@ struct WriterConfig
     ///\brief Execution scheme, if true, outermost transition is always taken first.
     bool parent_first_execution;
 
-    WriterConfig() : verbose(), do_tracing(), use_simple_names(), parent_first_execution() {}
+    ///\brief Only expose the public API in the header, and hide the private members behind a pimpl.
+    bool lean_header;
+
+    ///\brief Use the shared runtime header for timers, queues and tracing instead of per-model copies.
+    bool shared_runtime;
+
+    ///\brief Leave out unreachable states, transitions that can never fire and events that are never raised.
+    bool strip_dead_code;
+
+    ///\brief Merge states with identical actions and transitions before generating code.
+    bool minimize;
+
+    ///\brief Print the worst case steps needed to handle each event in each state.
+    bool wcet_report;
+
+    ///\brief Write a JSON report of type sizes and code shape next to the generated code.
+    bool footprint;
+
+    ///\brief Count dispatched events per state and taken transitions, readable through get_profile().
+    bool instrument;
+
+    ///\brief Profile of an instrumented machine, used to check hot transitions first and mark hot and cold code.
+    std::string profile;
+
+    ///\brief Capacity of the fixed size event queues, 0 uses the capacity from the diagram header.
+    size_t queue_capacity;
+
+    ///\brief Overflow policy of the fixed size event queues, empty uses the policy from the diagram header.
+    std::string queue_overflow;
+
+    ///\brief Capacity of the lock-free queue that in events from other threads are raised into, 0 to dispatch at once.
+    size_t ingress_capacity;
+
+    ///\brief Raising an event only queues it, process() and process_until() dispatch queued events within a budget.
+    bool deferred_dispatch;
+
+    ///\brief Dispatch through constant tables indexed by state and event, instead of a react function per state.
+    bool table_backend;
+
+    ///\brief Give every state one react function holding the transitions of its parents, instead of calling them.
+    bool flatten_dispatch;
+
+    ///\brief Switch on the event id in react functions, with the guards of each event grouped under its case.
+    bool event_switch;
+
+    ///\brief Keep the earliest timer deadline, so idle ticks skip the timers and next_timeout_ms() can be generated.
+    bool tickless_timers;
+
+    ///\brief Use the narrowest enum types, and keep only a bit and an expire time for each timer.
+    bool compact_layout;
+
+    ///\brief Also generate a fleet container, holding the fields of many instances in one array per field.
+    bool fleet;
+
+    ///\brief Let the fleet save a snapshot of its arrays to a file, and restore the arrays from one.
+    bool fleet_snapshot;
+
+    ///\brief Schedule the timers on a shared runtime TimerService, which only wakes the machines with a due timer.
+    bool timer_service;
+
+    ///\brief How the tracing hooks are stored and called, only used with tracing enabled.
+    TraceHook trace_hook;
+
+    ///\brief Record state changes, events, guards, transitions and timers into a runtime TraceRing, with a symbol map.
+    bool trace_ring;
+
+    WriterConfig() :
+        verbose(),
+        do_tracing(),
+        use_simple_names(),
+        parent_first_execution(),
+        lean_header(),
+        shared_runtime(),
+        strip_dead_code(),
+        minimize(),
+        wcet_report(),
+        footprint(),
+        instrument(),
+        profile(),
+        queue_capacity(),
+        queue_overflow(),
+        ingress_capacity(),
+        deferred_dispatch(),
+        table_backend(),
+        flatten_dispatch(),
+        event_switch(),
+        tickless_timers(),
+        compact_layout(),
+        fleet(),
+        fleet_snapshot(),
+        timer_service(),
+        trace_hook(TraceHook::Function),
+        trace_ring()
+    {
+    }
     ~WriterConfig() = default;
 };
 
+///\brief Prototype of a public function of the generated state machine.
+struct PublicFunction
+{
+    std::string return_type;
+    std::string name;
+    std::string parameters;
+    std::string arguments;
+    bool        is_const;
+    bool        is_static;
+    bool        is_nodiscard;
+
+    PublicFunction(std::string ret, std::string fn, std::string params, std::string args) :
+        return_type(std::move(ret)),
+        name(std::move(fn)),
+        parameters(std::move(params)),
+        arguments(std::move(args)),
+        is_const(),
+        is_static(),
+        is_nodiscard()
+    {
+    }
+    ~PublicFunction() = default;
+};
+
+///\brief Generated functions of one kind, where states with identical bodies share a single function.
+struct SharedFunctions
+{
+    ///\brief Body of each emitted function, keyed by the state that owns it.
+    std::map<StateId, std::string> bodies;
+
+    ///\brief State owning the function called for each state.
+    std::map<StateId, StateId> owners;
+
+    SharedFunctions() : bodies(), owners() {}
+    ~SharedFunctions() = default;
+};
+
+///\brief A transition as taken while a given state is active, with everything it runs resolved.
+struct DispatchPath
+{
+    ///\brief The transition, taken from the active state or one of its parents.
+    const Transition* transition;
+    const State*      source;
+
+    ///\brief Profile, exit, entry and trace statements in the order they run.
+    std::vector<std::string> actions;
+
+    ///\brief State entered, a choice if its guards decide, nullptr if the state does not change.
+    State* target;
+
+    DispatchPath() : transition(), source(), actions(), target() {}
+    ~DispatchPath() = default;
+};
+
+///\brief A dispatch path of the table backend, as indices into the tables.
+struct DispatchEntry
+{
+    ///\brief Index into the guards, 0 if the transition has no guard.
+    size_t guard;
+
+    ///\brief Index of every action, in the order they run.
+    std::vector<size_t> actions;
+
+    ///\brief Index of the state entered, -1 if a choice or the actions decide it.
+    long target;
+
+    DispatchEntry() : guard(), actions(), target(-1) {}
+    ~DispatchEntry() = default;
+};
+
+///\brief Tables of the table backend, shared by all instances of the generated machine.
+struct DispatchTables
+{
+    std::vector<std::string> events;
+    std::vector<std::string> guards;
+    std::vector<std::string> actions;
+    std::vector<State*>      choices;
+
+    ///\brief First path and number of paths for each state and event, row by row.
+    std::vector<std::pair<size_t, size_t>> cells;
+    std::vector<DispatchEntry>             paths;
+
+    DispatchTables() : events(), guards(), actions(), choices(), cells(), paths() {}
+    ~DispatchTables() = default;
+};
+
 class Writer
 {
   private:
@@ -37,55 +236,216 @@ class Writer
     Style        styler;
     size_t       indent;
 
+    SharedFunctions entry_functions;
+    SharedFunctions exit_functions;
+    SharedFunctions react_functions;
+    Profile         profile;
+    size_t          queue_capacity;
+    QueueOverflow   queue_overflow;
+    DispatchTables  tables;
+
     ///\brief Start the namespace tag using the model name as the namespace.
-    void start_namespace(std::ofstream& out);
+    void start_namespace(std::ostream& out);
 
     ///\brief Finishes the namespace.
-    void end_namespace(std::ofstream& out);
+    void end_namespace(std::ostream& out);
 
     ///\brief Write the declaration of the model states.
-    void decl_state_list(std::ofstream& out);
+    void decl_state_list(std::ostream& out);
 
     ///\brief Write the declaration of the model events.
-    void decl_event_list(std::ofstream& out);
+    void decl_event_list(std::ostream& out);
+
+    ///\brief Write the fixed capacity queue used when the queue capacity is set.
+    void decl_event_ring(std::ostream& out);
+
+    ///\brief Write the lock-free queue used for in events raised from other threads.
+    void decl_event_ingress(std::ostream& out);
+
+    ///\brief Write the declaration of the model time events.
+    void decl_time_event_list(std::ostream& out);
 
     ///\brief Write the declaration of the model variables.
-    void decl_variable_list(std::ofstream& out);
+    void decl_variable_list(std::ostream& out);
 
     ///\brief Write the declaration of the tracing functions.
-    void decl_tracing_callback(std::ofstream& out);
+    void decl_tracing_callback(std::ostream& out);
 
     ///\brief Write the declaration of the state machine.
-    void decl_state_machine(std::ofstream& out);
+    void decl_state_machine(std::ostream& out);
+
+    ///\brief Write the declaration of the public interface used in lean header mode.
+    void decl_lean_interface(std::ostream& out);
+
+    ///\brief Write the implementation of the public interface forwarding to the private implementation.
+    void impl_lean_interface(std::ostream& out);
+
+    ///\brief Write the declaration of the fleet container, with the fields of all instances in arrays.
+    void decl_fleet(std::ostream& out);
+
+    ///\brief Write the implementation of the fleet container, which runs each instance on a shared worker.
+    void impl_fleet(std::ostream& out);
+    void impl_fleet_load(std::ostream& out);
+    void impl_fleet_store(std::ostream& out);
+    void impl_fleet_set_state(std::ostream& out);
+
+    ///\brief Write save() and restore() of fleet snapshots, with a header that rejects snapshots of other layouts.
+    void                                             impl_fleet_snapshot(std::ostream& out);
+    std::vector<std::pair<std::string, std::string>> get_fleet_arrays();
+    uint64_t                                         get_fleet_layout_hash();
+    void impl_fleet_time_tick(std::ostream& out);
+
+    ///\brief Write expire_timer(), which dispatches the expired deadlines of one timer and keeps the earliest other.
+    void impl_fleet_expire_timer(std::ostream& out);
+    void impl_fleet_timer_scan(std::ostream& out, const std::string& prefix, const std::string& vector, size_t lanes);
+    void impl_fleet_timer_expire(std::ostream& out, const std::string& id);
+    void impl_fleet_dispatch(std::ostream& out);
+
+    ///\brief Write the broadcast of one event to every instance, which only runs the worker where actions run.
+    void impl_fleet_broadcast(std::ostream& out);
+    void impl_fleet_broadcast_visit(std::ostream& out, const std::string& id);
+    void impl_fleet_broadcast_simd(
+        std::ostream&      out,
+        const std::string& prefix,
+        const std::string& vector,
+        size_t             lanes);
+    bool                     is_fleet_simd();
+    std::vector<std::string> get_event_ids();
+
+    std::vector<PublicFunction> get_fleet_functions();
+    std::string                 get_fleet_name() const;
 
     ///\brief Write the implementation of the init function.
-    void impl_init(std::ofstream& out, const std::vector<State*>& first_state);
+    void impl_init(std::ostream& out, const std::vector<State*>& first_state);
 
     ///\brief Write the implementation of all raise in event functions.
-    void impl_raise_in_event(std::ofstream& out);
+    void impl_raise_in_event(std::ostream& out);
 
     ///\brief Write the implementation of all raise out event functions.
-    void impl_raise_out_event(std::ofstream& out);
+    void impl_raise_out_event(std::ostream& out);
 
     ///\brief Write the implementation of all raise internal event functions.
-    void impl_raise_internal_event(std::ofstream& out);
+    void impl_raise_internal_event(std::ostream& out);
+
+    void impl_queue_push(std::ostream& out, const std::string& queue);
+    void impl_drain(std::ostream& out);
+    void impl_process(std::ostream& out);
+    void impl_check_out_event(std::ostream& out);
+    void impl_get_variable(std::ostream& out);
+    void impl_time_tick(std::ostream& out);
+
+    ///\brief Write the checks that queue the event of each timer expired at time_now_ms.
+    void impl_timer_expiry(std::ostream& out);
+    void impl_next_timeout(std::ostream& out);
+    void impl_timer_deadline(std::ostream& out, const Event* ev);
+
+    ///\brief Write on_timer(), which expires the timers due when the service wakes the machine, and the destructor.
+    void impl_on_timer(std::ostream& out);
+    void impl_timer_stop(std::ostream& out, const Event* ev);
+
+    ///\brief Write the removal of the pending entry of a running timer from the timer service.
+    void impl_timer_cancel(std::ostream& out, const Event* ev);
+
+    ///\brief Timers of the compact layout share one integer of running flags and have constant timeouts.
+    bool        is_compact_timers();
+    std::string get_timer_bits_type();
+    std::string get_timer_mask(const Event* ev);
+    size_t      get_timer_index(const Event* ev);
+    bool        uses_timer_service() const;
+    std::string get_timer_running(const Event* ev, const std::string& object);
+    std::string get_timer_expire(const Event* ev, const std::string& object);
+    void impl_top_run_cycle(std::ostream& out);
+
+    ///\brief Transitions of the state and its parents in the order they are tried, with their actions resolved.
+    std::vector<DispatchPath> get_dispatch_paths(State* state);
+    std::string               get_event_id(const Transition* tr) const;
+    bool                      is_parent_first() const;
+    void                      impl_flat_react_body(std::ostream& out, State* state);
+    void                      impl_flat_path_body(std::ostream& out, State* state, const DispatchPath& path);
+    std::string               get_react_parameters() const;
+
+    ///\brief Resolve every transition of every state for the table backend.
+    void   build_dispatch_tables();
+    size_t add_dispatch_action(const std::string& statement);
+    void   decl_dispatch_tables(std::ostream& out);
+    void   impl_table_run_cycle(std::ostream& out);
+    void   impl_table_functions(std::ostream& out);
+
+    void impl_trace_calls(std::ostream& out);
+
+    ///\brief Write the trace function of one hook, which calls the static tracer or the hook set at run time.
+    void impl_trace_hook(
+        std::ostream&      out,
+        const std::string& function,
+        const std::string& hook,
+        const std::string& state);
+    void impl_trace_setter(std::ostream& out, const std::string& hook, const std::string& type);
+    bool uses_trace_hook(TraceHook hook) const;
 
-    void impl_check_out_event(std::ofstream& out);
-    void impl_get_variable(std::ofstream& out);
-    void impl_time_tick(std::ofstream& out);
-    void impl_top_run_cycle(std::ofstream& out);
-    void impl_trace_calls(std::ofstream& out);
-    void impl_run_cycle(std::ofstream& out);
-    void impl_entry_action(std::ofstream& out);
-    void impl_exit_action(std::ofstream& out);
+    ///\brief True if the machine calls trace_state_enter() and trace_state_exit(), for the hooks or the trace ring.
+    bool uses_state_trace() const;
+
+    ///\brief Write set_trace_ring() and the functions that append records to the ring.
+    void        impl_trace_ring(std::ostream& out);
+    std::string get_trace_record(const std::string& kind, const std::string& id);
+    std::string get_guard_check(const Transition* tr);
+    size_t      get_transition_index(const Transition* tr);
+
+    ///\brief Write <model>.trace.map, naming the ids of the trace records.
+    bool generate_trace_map(const std::string& path);
+    void impl_run_cycle(std::ostream& out);
+    void impl_react_body(std::ostream& out, State* state);
+    void impl_transition_body(std::ostream& out, State* state, Transition* tr);
+
+    ///\brief Transitions grouped by event in the order they are tried, empty if the react function keeps its if chain.
+    std::vector<std::pair<std::string, std::vector<size_t>>> get_event_cases(
+        const std::vector<const Transition*>& transitions);
+    void impl_event_switch(
+        std::ostream&                         out,
+        const std::vector<const Transition*>& transitions,
+        const std::function<void(size_t)>&    write_body);
+    void impl_entry_action(std::ostream& out);
+    void impl_entry_body(std::ostream& out, State* state);
+    void impl_exit_action(std::ostream& out);
+    void impl_exit_body(std::ostream& out, State* state);
+
+    ///\brief Write a comment listing the other states calling a shared function.
+    void impl_shared_note(std::ostream& out, const SharedFunctions& functions, const State* state);
+
+    ///\brief Render all entry, exit and react bodies, so that identical ones are emitted only once.
+    void find_shared_functions();
+    static void share_function(SharedFunctions& functions, const State* state, const std::string& body);
+
+    ///\brief Write the implementation of get_profile for instrumented machines.
+    void impl_profile(std::ostream& out);
+
+    ///\brief Write the macros for the branch and function hints used with a profile.
+    void write_profile_macros(std::ostream& out);
+
+    std::vector<State*>      get_enum_states();
+    std::vector<Transition*> get_profiled_transitions();
+    size_t                   get_profile_index(const Transition* tr);
+    std::vector<Transition*> get_transition_order(const State* state);
+    std::vector<State*>      get_definition_order();
+    size_t                   get_activity(const State* state);
+    std::string              get_branch_hint(const Transition* tr);
+    std::string              get_function_hint(const SharedFunctions& functions, const State* state);
+
+    const State* get_function_owner(const SharedFunctions& functions, const State* state);
+    std::string  get_entry_function(const State* state);
+    std::string  get_exit_function(const State* state);
+    std::string  get_react_function(const State* state);
 
     static std::vector<std::string> tokenize(const std::string& str);
-    void                            parse_declaration(std::ofstream& out, const std::string& declaration);
+    void                            parse_declaration(std::ostream& out, const std::string& declaration);
     std::string                     parse_guard(const std::string& guardStrRaw);
-    void                            parse_choice_path(std::ofstream& out, State* initialChoice);
+    void                            parse_choice_path(std::ostream& out, State* initialChoice);
 
     std::vector<State*> get_child_states(State* currentState);
-    bool parse_child_exits(std::ofstream& out, State* currentState, StateId topState, bool didPreviousWrite);
+    bool parse_child_exits(std::ostream& out, State* currentState, StateId topState, bool didPreviousWrite);
+
+    ///\brief Check if a leaf below the state has no exit action on its way up to the top state.
+    bool has_leaf_without_exit(State* currentState, StateId topState);
 
     bool has_entry_statement(StateId stateId);
     bool has_exit_statement(StateId stateId);
@@ -95,6 +455,15 @@ class Writer
     std::vector<State*> find_init_state();
     std::vector<State*> find_entry_state(State* in);
     std::vector<State*> find_final_state(State* in);
+    void                write_runtime_include(std::ostream& out);
+    std::string         get_queue_type(const std::string& type) const;
+    std::string         get_raise_in_type() const;
+    std::string         get_ingress_type() const;
+    std::string         get_enum_base(size_t count) const;
+    std::string         get_class_scope() const;
+    std::string         get_class_name() const;
+    std::vector<PublicFunction> get_public_functions();
+    static std::string  get_prototype(const PublicFunction& fn);
     std::string         get_indent() const;
     static std::string         get_if_else_if(size_t i);
 
@@ -0,0 +1,912 @@
+/** @file
+ *  @brief Implementation of the analyzer class.
+ */
+
+#include "../include/analyzer.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+Analyzer::Analyzer(Reader& reader, const bool parent_first_execution, const DispatchBackend backend) :
+    reader(reader),
+    parent_first_execution(parent_first_execution),
+    backend(backend),
+    reachable_states(),
+    active_states(),
+    raised_events(),
+    dead_transitions()
+{
+}
+
+bool Analyzer::contains(const std::vector<StateId>& ids, const StateId id)
+{
+    return ids.end() != std::find(ids.begin(), ids.end(), id);
+}
+
+bool Analyzer::is_reachable(const StateId id) const
+{
+    return contains(reachable_states, id);
+}
+
+bool Analyzer::is_active(const StateId id) const
+{
+    return contains(active_states, id);
+}
+
+bool Analyzer::is_pseudo_state(const State* state)
+{
+    return ("initial" == state->name) || ("final" == state->name);
+}
+
+void Analyzer::analyze()
+{
+    reachable_states.clear();
+    active_states.clear();
+    raised_events.clear();
+    dead_transitions.clear();
+
+    std::vector<StateId> visited_choices {};
+    for (auto i = 0u; i < reader.getStateCount(); i++)
+    {
+        auto state = reader.getState(i);
+        if (("initial" == state->name) && (0 == state->parent))
+        {
+            auto tr = reader.getTransitionFrom(state->id, 0);
+            if ((nullptr != tr) && (nullptr != reader.getStateById(tr->state_b)))
+            {
+                enter_state(reader.getStateById(tr->state_b), visited_choices);
+            }
+        }
+    }
+
+    // entering states may raise more events, which may open up more transitions, so repeat until stable.
+    size_t n_reachable = 0;
+    size_t n_raised    = 0;
+    while ((n_reachable != reachable_states.size()) || (n_raised != raised_events.size()))
+    {
+        n_reachable = reachable_states.size();
+        collect_raised_events();
+        n_raised = raised_events.size();
+
+        for (auto i = 0u; i < active_states.size(); i++)
+        {
+            for (auto state : get_ancestors(reader.getStateById(active_states[i])))
+            {
+                for (auto j = 0u; j < reader.getTransitionCountFromStateId(state->id); j++)
+                {
+                    auto tr     = reader.getTransitionFrom(state->id, j);
+                    auto target = reader.getStateById(tr->state_b);
+                    if (("null" != tr->event.name) && (nullptr != target) && get_dead_reason(tr).empty())
+                    {
+                        visited_choices.clear();
+                        enter_state(target, visited_choices);
+                    }
+                }
+            }
+        }
+    }
+
+    for (auto i = 0u; i < reader.getTransitionCount(); i++)
+    {
+        auto tr     = reader.getTransition(i);
+        auto source = reader.getStateById(tr->state_a);
+        if ((nullptr == source) || ("initial" == source->name))
+        {
+            // entry transitions are followed when entering the parent.
+            continue;
+        }
+
+        DeadTransition dead {};
+        dead.index = i;
+        if (!is_reachable(source->id))
+        {
+            dead.reason = "state " + source->name + " is unreachable";
+        }
+        else
+        {
+            dead.reason = get_dead_reason(tr);
+        }
+
+        if (!dead.reason.empty())
+        {
+            dead_transitions.push_back(dead);
+        }
+    }
+}
+
+void Analyzer::enter_state(State* state, std::vector<StateId>& visited_choices)
+{
+    const auto path = get_entry_path(state);
+    for (auto s : path)
+    {
+        mark_reachable(s->id);
+    }
+
+    auto last = path.back();
+    if (last->is_choice)
+    {
+        if (!contains(visited_choices, last->id))
+        {
+            visited_choices.push_back(last->id);
+            for (auto tr : get_choice_branches(last))
+            {
+                auto target = reader.getStateById(tr->state_b);
+                if (nullptr != target)
+                {
+                    enter_state(target, visited_choices);
+                }
+            }
+        }
+    }
+    else if (!is_pseudo_state(last) && !is_active(last->id))
+    {
+        active_states.push_back(last->id);
+        for (auto s : get_ancestors(last))
+        {
+            mark_reachable(s->id);
+        }
+    }
+}
+
+void Analyzer::mark_reachable(const StateId id)
+{
+    if (!is_reachable(id))
+    {
+        reachable_states.push_back(id);
+    }
+}
+
+void Analyzer::collect_raised_events()
+{
+    for (auto id : reachable_states)
+    {
+        for (auto type : { Declaration::Entry, Declaration::Exit })
+        {
+            for (auto j = 0u; j < reader.getDeclCount(id, type); j++)
+            {
+                const auto name = get_raised_event(reader.getDeclFromStateId(id, type, j)->declaration);
+                if (!name.empty()
+                    && (raised_events.end() == std::find(raised_events.begin(), raised_events.end(), name)))
+                {
+                    raised_events.push_back(name);
+                }
+            }
+        }
+    }
+}
+
+std::string Analyzer::get_raised_event(const std::string& declaration)
+{
+    // the writer only lowers the first raise of a declaration.
+    std::istringstream iss(declaration);
+    std::string        token {};
+    while (iss >> token)
+    {
+        if ("raise" == token)
+        {
+            if (iss >> token)
+            {
+                return token;
+            }
+            break;
+        }
+    }
+    return {};
+}
+
+std::string Analyzer::get_dead_reason(Transition* tr)
+{
+    auto source = reader.getStateById(tr->state_a);
+
+    if (source->is_choice)
+    {
+        const auto branches = get_choice_branches(source);
+        if (branches.end() == std::find(branches.begin(), branches.end(), tr))
+        {
+            return "only the last unguarded transition of a choice is taken";
+        }
+        return {};
+    }
+
+    if ("null" == tr->event.name)
+    {
+        return {};
+    }
+
+    // an earlier unguarded transition on the same event always wins.
+    for (auto j = 0u; j < reader.getTransitionCountFromStateId(source->id); j++)
+    {
+        auto other = reader.getTransitionFrom(source->id, j);
+        if (other == tr)
+        {
+            break;
+        }
+        if (!other->has_guard && (other->event.name == tr->event.name))
+        {
+            return "shadowed by " + describe(other);
+        }
+    }
+
+    // with parent first execution, an unguarded transition of any parent consumes the event.
+    if (parent_first_execution)
+    {
+        auto ancestors = get_ancestors(source);
+        for (auto it = ancestors.begin() + 1; it != ancestors.end(); it++)
+        {
+            for (auto j = 0u; j < reader.getTransitionCountFromStateId((*it)->id); j++)
+            {
+                auto other = reader.getTransitionFrom((*it)->id, j);
+                if (!other->has_guard && (other->event.name == tr->event.name))
+                {
+                    return "shadowed by " + describe(other) + " of a parent state";
+                }
+            }
+        }
+    }
+
+    if (!tr->event.is_time_event)
+    {
+        if (EventDirection::Outgoing == tr->event.direction)
+        {
+            return "event " + tr->event.name + " is an out event";
+        }
+        if ((EventDirection::Internal == tr->event.direction)
+            && (raised_events.end() == std::find(raised_events.begin(), raised_events.end(), tr->event.name)))
+        {
+            return "event " + tr->event.name + " is never raised";
+        }
+    }
+
+    return {};
+}
+
+std::string Analyzer::describe(const Transition* tr)
+{
+    auto source = reader.getStateById(tr->state_a);
+    auto target = reader.getStateById(tr->state_b);
+
+    std::string s = (nullptr == source) ? "null" : source->name;
+    s += " -> ";
+    s += (nullptr == target) ? "null" : target->name;
+    if ("null" != tr->event.name)
+    {
+        s += " : " + tr->event.name;
+    }
+    if (tr->has_guard)
+    {
+        s += " [" + tr->guard + "]";
+    }
+    return s;
+}
+
+bool Analyzer::is_event_used(const Event* event)
+{
+    for (auto i = 0u; i < reader.getTransitionCount(); i++)
+    {
+        auto tr = reader.getTransition(i);
+        if (event->name == tr->event.name)
+        {
+            const bool is_dead = dead_transitions.end()
+                                 != std::find_if(
+                                         dead_transitions.begin(),
+                                         dead_transitions.end(),
+                                         [i](const DeadTransition& d)
+                                         {
+                                             return i == d.index;
+                                         });
+            if (!is_dead)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void Analyzer::report()
+{
+    for (auto i = 0u; i < reader.getStateCount(); i++)
+    {
+        auto state = reader.getState(i);
+        if (!is_pseudo_state(state) && !is_reachable(state->id))
+        {
+            std::cout << "WARN: State " << state->name << " is unreachable." << std::endl;
+        }
+    }
+
+    for (const auto& dead : dead_transitions)
+    {
+        auto tr = reader.getTransition(dead.index);
+        if (is_reachable(tr->state_a))
+        {
+            std::cout << "WARN: Transition " << describe(tr) << " can never fire, " << dead.reason << "."
+                      << std::endl;
+        }
+    }
+
+    for (auto i = 0u; i < reader.getInternalEventCount(); i++)
+    {
+        auto ev = reader.getInternalEvent(i);
+        if (raised_events.end() == std::find(raised_events.begin(), raised_events.end(), ev->name))
+        {
+            std::cout << "WARN: Event " << ev->name << " is never raised." << std::endl;
+        }
+    }
+
+    for (auto i = 0u; i < reader.getInEventCount(); i++)
+    {
+        auto ev = reader.getInEvent(i);
+        if (("null" != ev->name) && !is_event_used(ev))
+        {
+            std::cout << "WARN: In event " << ev->name << " does not trigger any transition." << std::endl;
+        }
+    }
+}
+
+void Analyzer::eliminate_dead_code()
+{
+    std::vector<size_t> transitions {};
+    for (const auto& dead : dead_transitions)
+    {
+        transitions.push_back(dead.index);
+    }
+
+    std::vector<StateId> states {};
+    for (auto i = 0u; i < reader.getStateCount(); i++)
+    {
+        auto state = reader.getState(i);
+        if (is_pseudo_state(state))
+        {
+            if ((0 != state->parent) && !is_reachable(state->parent))
+            {
+                states.push_back(state->id);
+            }
+        }
+        else if (!is_reachable(state->id))
+        {
+            states.push_back(state->id);
+        }
+    }
+
+    // also drop anything leading into a removed state.
+    for (auto i = 0u; i < reader.getTransitionCount(); i++)
+    {
+        auto tr = reader.getTransition(i);
+        if (contains(states, tr->state_a) || contains(states, tr->state_b))
+        {
+            transitions.push_back(i);
+        }
+    }
+
+    std::sort(transitions.begin(), transitions.end());
+    transitions.erase(std::unique(transitions.begin(), transitions.end()), transitions.end());
+    for (auto it = transitions.rbegin(); it != transitions.rend(); it++)
+    {
+        reader.remove_transition(*it);
+    }
+
+    for (auto id : states)
+    {
+        reader.remove_state(id);
+    }
+
+    // internal events that are never raised, and time events without transitions.
+    std::vector<std::string> events {};
+    for (auto i = 0u; i < reader.getInternalEventCount(); i++)
+    {
+        auto ev = reader.getInternalEvent(i);
+        if (raised_events.end() == std::find(raised_events.begin(), raised_events.end(), ev->name))
+        {
+            events.push_back(ev->name);
+        }
+    }
+    for (const auto& name : events)
+    {
+        reader.remove_event(name);
+    }
+    const auto n_events = events.size() + remove_unused_time_events();
+
+    if (!states.empty() || !transitions.empty() || (0 < n_events))
+    {
+        std::cout << "Removed " << states.size() << " states, " << transitions.size() << " transitions and "
+                  << n_events << " events." << std::endl;
+    }
+
+    analyze();
+}
+
+void Analyzer::minimize()
+{
+    // start out with all mergeable states in one block, every other state is kept apart.
+    std::map<StateId, size_t> blocks {};
+    std::vector<bool>         mergeable {};
+    for (auto i = 0u; i < reader.getStateCount(); i++)
+    {
+        auto state = reader.getState(i);
+        mergeable.push_back(!is_pseudo_state(state) && !state->is_choice && is_leaf_state(state));
+        blocks[state->id] = mergeable.back() ? 0 : (i + 1);
+    }
+
+    // split blocks on their signature until stable, the signature includes the block of each transition target.
+    size_t n_blocks = 0;
+    while (true)
+    {
+        std::map<std::string, size_t> signatures {};
+        std::map<StateId, size_t>     refined {};
+        for (auto i = 0u; i < reader.getStateCount(); i++)
+        {
+            auto state     = reader.getState(i);
+            auto signature = mergeable[i] ? get_signature(state, blocks) : ("#" + std::to_string(state->id));
+            if (signatures.end() == signatures.find(signature))
+            {
+                const auto block      = signatures.size();
+                signatures[signature] = block;
+            }
+            refined[state->id] = signatures[signature];
+        }
+        blocks = refined;
+        if (n_blocks == signatures.size())
+        {
+            break;
+        }
+        n_blocks = signatures.size();
+    }
+
+    // the first state of each block is kept, the others are merged into it.
+    std::map<size_t, State*>  representatives {};
+    std::map<StateId, State*> merged {};
+    for (auto i = 0u; i < reader.getStateCount(); i++)
+    {
+        auto state = reader.getState(i);
+        auto block = blocks[state->id];
+        if (representatives.end() == representatives.find(block))
+        {
+            representatives[block] = state;
+        }
+        else
+        {
+            merged[state->id] = representatives[block];
+            std::cout << "Merged state " << state->name << " into " << representatives[block]->name << "."
+                      << std::endl;
+        }
+    }
+
+    for (auto i = reader.getTransitionCount(); 0 < i; i--)
+    {
+        auto tr = reader.getTransition(i - 1);
+        if (merged.end() != merged.find(tr->state_a))
+        {
+            reader.remove_transition(i - 1);
+        }
+        else if (merged.end() != merged.find(tr->state_b))
+        {
+            tr->state_b = merged[tr->state_b]->id;
+        }
+    }
+    for (const auto& m : merged)
+    {
+        reader.remove_state(m.first);
+    }
+    remove_unused_time_events();
+
+    analyze();
+}
+
+void Analyzer::report_wcet()
+{
+    struct Row
+    {
+        std::string   state;
+        std::string   event;
+        ExecutionCost cost;
+    };
+    std::vector<Row> rows {};
+    size_t           state_width = 5;
+    size_t           event_width = 5;
+
+    for (auto i = 0u; i < reader.getStateCount(); i++)
+    {
+        auto state = reader.getState(i);
+        if (!is_active(state->id))
+        {
+            continue;
+        }
+
+        // every event with a transition on the active state or one of its parents.
+        std::vector<std::string> events {};
+        for (auto s : get_ancestors(state))
+        {
+            for (auto j = 0u; j < reader.getTransitionCountFromStateId(s->id); j++)
+            {
+                const auto& name = reader.getTransitionFrom(s->id, j)->event.name;
+                if (("null" != name) && (events.end() == std::find(events.begin(), events.end(), name)))
+                {
+                    events.push_back(name);
+                }
+            }
+        }
+
+        for (const auto& event : events)
+        {
+            rows.push_back({ state->name, event, get_worst_cost(state, event) });
+            state_width = std::max(state_width, state->name.size());
+            event_width = std::max(event_width, event.size());
+        }
+    }
+
+    std::stable_sort(rows.begin(),
+                     rows.end(),
+                     [](const Row& a, const Row& b)
+                     {
+                         return a.cost.total > b.cost.total;
+                     });
+
+    std::cout << "Worst case per state and event, most expensive first:" << std::endl;
+    std::cout << std::left << std::setw(static_cast<int>(state_width + 2)) << "State"
+              << std::setw(static_cast<int>(event_width + 2)) << "Event" << std::right << std::setw(6) << "Total"
+              << std::setw(7) << "Depth" << std::setw(8) << "Reacts" << std::setw(8) << "Guards" << std::setw(8)
+              << "Checks" << std::setw(7) << "Exits" << std::setw(9) << "Entries" << std::endl;
+    for (const auto& row : rows)
+    {
+        std::cout << std::left << std::setw(static_cast<int>(state_width + 2)) << row.state
+                  << std::setw(static_cast<int>(event_width + 2)) << row.event << std::right << std::setw(6)
+                  << row.cost.total << std::setw(7) << row.cost.depth << std::setw(8) << row.cost.reacts
+                  << std::setw(8) << row.cost.guards << std::setw(8) << row.cost.checks << std::setw(7)
+                  << row.cost.exits << std::setw(9) << row.cost.entries << std::endl;
+    }
+}
+
+ExecutionCost Analyzer::get_worst_cost(State* active, const std::string& event)
+{
+    // each react function calls its parent first, so the outermost state evaluates its transitions first. With
+    // child first execution the dispatch starts at the active state and only moves outwards while unconsumed. The
+    // flat and table backends try the same transitions in the same order, from one react function or none at all.
+    const auto    ancestors = get_ancestors(active);
+    ExecutionCost worst {};
+    size_t        guards   = 0;
+    bool          consumed = false;
+    for (size_t n = 0; (n < ancestors.size()) && !consumed; n++)
+    {
+        const auto level  = parent_first_execution ? (ancestors.size() - n) : (n + 1);
+        auto       source = ancestors[level - 1];
+        for (auto j = 0u; (j < reader.getTransitionCountFromStateId(source->id)) && !consumed; j++)
+        {
+            auto tr = reader.getTransitionFrom(source->id, j);
+            if (event != tr->event.name)
+            {
+                continue;
+            }
+            if (tr->has_guard)
+            {
+                guards++;
+            }
+            else
+            {
+                // nothing after an unguarded transition is ever evaluated.
+                consumed = true;
+            }
+
+            auto target = reader.getStateById(tr->state_b);
+            if (nullptr != target)
+            {
+                auto       path  = get_exit_cost(active, source);
+                const auto entry = get_entry_cost(target, {});
+                const auto calls = ((0 < path.exits) || (0 < path.entries)) ? 1 : 0;
+                path.guards      = guards + entry.guards;
+                path.entries     = entry.entries;
+                if (DispatchBackend::Recursive == backend)
+                {
+                    path.reacts = parent_first_execution ? ancestors.size() : level;
+                    path.depth  = level + calls;
+                }
+                else
+                {
+                    // the active state is known, so its exit actions are called without any check.
+                    path.checks = 0;
+                    path.reacts = (DispatchBackend::Flat == backend) ? 1 : 0;
+                    path.depth  = path.reacts + calls;
+                }
+                add_path(worst, path);
+            }
+        }
+    }
+
+    if (!consumed)
+    {
+        // all guards failed, the event is dropped.
+        ExecutionCost path {};
+        path.reacts = ancestors.size();
+        if (DispatchBackend::Recursive != backend)
+        {
+            path.reacts = (DispatchBackend::Flat == backend) ? 1 : 0;
+        }
+        path.depth  = path.reacts;
+        path.guards = guards;
+        add_path(worst, path);
+    }
+    return worst;
+}
+
+ExecutionCost Analyzer::get_exit_cost(State* active, State* source)
+{
+    // mirrors the writer, which checks the active state against every leaf with exit actions below the source.
+    ExecutionCost        cost {};
+    std::vector<StateId> leaves {};
+    collect_exit_branches(source, source->id, leaves);
+    if (leaves.empty())
+    {
+        cost.exits = has_exit_action(source->id) ? 1 : 0;
+        return cost;
+    }
+
+    auto it = std::find(leaves.begin(), leaves.end(), active->id);
+    if (leaves.end() == it)
+    {
+        // none of the checks match, the source is exited on its own.
+        cost.checks = leaves.size();
+        cost.exits  = has_exit_action(source->id) ? 1 : 0;
+        return cost;
+    }
+
+    cost.checks = static_cast<size_t>(it - leaves.begin()) + 1;
+    for (auto state : get_ancestors(active))
+    {
+        cost.exits += has_exit_action(state->id) ? 1 : 0;
+        if (source == state)
+        {
+            break;
+        }
+    }
+    return cost;
+}
+
+ExecutionCost Analyzer::get_entry_cost(State* target, std::vector<StateId> visited_choices)
+{
+    ExecutionCost cost {};
+    const auto    path = get_entry_path(target);
+    for (auto state : path)
+    {
+        cost.entries += has_entry_action(state->id) ? 1 : 0;
+    }
+
+    auto last = path.back();
+    if (last->is_choice && !contains(visited_choices, last->id))
+    {
+        // the guarded branches are evaluated in order, the default is taken when all of them fail.
+        visited_choices.push_back(last->id);
+        ExecutionCost worst {};
+        size_t        guards = 0;
+        for (auto tr : get_choice_branches(last))
+        {
+            guards += tr->has_guard ? 1 : 0;
+            auto next = reader.getStateById(tr->state_b);
+            if (nullptr != next)
+            {
+                auto branch = get_entry_cost(next, visited_choices);
+                branch.guards += guards;
+                add_path(worst, branch);
+            }
+        }
+        cost.guards += worst.guards;
+        cost.entries += worst.entries;
+    }
+    return cost;
+}
+
+void Analyzer::add_path(ExecutionCost& worst, ExecutionCost path)
+{
+    path.total    = path.reacts + path.guards + path.checks + path.exits + path.entries;
+    worst.depth   = std::max(worst.depth, path.depth);
+    worst.reacts  = std::max(worst.reacts, path.reacts);
+    worst.guards  = std::max(worst.guards, path.guards);
+    worst.checks  = std::max(worst.checks, path.checks);
+    worst.exits   = std::max(worst.exits, path.exits);
+    worst.entries = std::max(worst.entries, path.entries);
+    worst.total   = std::max(worst.total, path.total);
+}
+
+void Analyzer::collect_exit_branches(State* state, const StateId top, std::vector<StateId>& leaves)
+{
+    const auto children = get_child_states(state);
+    if (children.empty())
+    {
+        for (auto s = state; (nullptr != s) && (top != s->id); s = reader.getStateById(s->parent))
+        {
+            if (has_exit_action(s->id))
+            {
+                leaves.push_back(state->id);
+                break;
+            }
+        }
+    }
+    else
+    {
+        for (auto child : children)
+        {
+            collect_exit_branches(child, top, leaves);
+        }
+    }
+}
+
+std::vector<State*> Analyzer::get_child_states(const State* state)
+{
+    std::vector<State*> children {};
+    for (auto i = 0u; i < reader.getStateCount(); i++)
+    {
+        auto child = reader.getState(i);
+        if ((state->id == child->parent) && !is_pseudo_state(child) && !child->is_choice)
+        {
+            children.push_back(child);
+        }
+    }
+    return children;
+}
+
+bool Analyzer::has_entry_action(const StateId id)
+{
+    // starting the timers of time events is part of the entry action.
+    if (0 < reader.getDeclCount(id, Declaration::Entry))
+    {
+        return true;
+    }
+    for (auto j = 0u; j < reader.getTransitionCountFromStateId(id); j++)
+    {
+        if (reader.getTransitionFrom(id, j)->event.is_time_event)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Analyzer::has_exit_action(const StateId id)
+{
+    if (0 < reader.getDeclCount(id, Declaration::Exit))
+    {
+        return true;
+    }
+    for (auto j = 0u; j < reader.getTransitionCountFromStateId(id); j++)
+    {
+        if (reader.getTransitionFrom(id, j)->event.is_time_event)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Analyzer::is_leaf_state(const State* state)
+{
+    for (auto i = 0u; i < reader.getStateCount(); i++)
+    {
+        if (state->id == reader.getState(i)->parent)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string Analyzer::get_signature(const State* state, const std::map<StateId, size_t>& blocks)
+{
+    // everything observable from the outside, comments are left out on purpose.
+    std::string signature = std::to_string(blocks.at(state->id)) + "|" + std::to_string(state->parent);
+    for (auto type : { Declaration::Entry, Declaration::Exit, Declaration::OnCycle })
+    {
+        signature += "|";
+        for (auto j = 0u; j < reader.getDeclCount(state->id, type); j++)
+        {
+            signature += reader.getDeclFromStateId(state->id, type, j)->declaration + ";";
+        }
+    }
+    for (auto j = 0u; j < reader.getTransitionCountFromStateId(state->id); j++)
+    {
+        auto tr = reader.getTransitionFrom(state->id, j);
+        signature += "|" + get_event_key(tr) + "[" + (tr->has_guard ? tr->guard : "") + "]";
+        signature += std::to_string(blocks.at(tr->state_b));
+    }
+    return signature;
+}
+
+std::string Analyzer::get_event_key(const Transition* tr)
+{
+    if (tr->event.is_time_event)
+    {
+        // time events are named after their state, only the timing part matters.
+        auto source = reader.getStateById(tr->state_a);
+        return "time:" + tr->event.name.substr(source->name.size());
+    }
+    return tr->event.name;
+}
+
+size_t Analyzer::remove_unused_time_events()
+{
+    std::vector<std::string> events {};
+    for (auto i = 0u; i < reader.getTimeEventCount(); i++)
+    {
+        auto ev     = reader.getTimeEvent(i);
+        bool in_use = false;
+        for (auto j = 0u; j < reader.getTransitionCount(); j++)
+        {
+            in_use = in_use || (ev->name == reader.getTransition(j)->event.name);
+        }
+        if (!in_use)
+        {
+            events.push_back(ev->name);
+        }
+    }
+    for (const auto& name : events)
+    {
+        reader.remove_event(name);
+    }
+    return events.size();
+}
+
+std::vector<State*> Analyzer::get_entry_path(State* state)
+{
+    // same walk as the writer, follow the initial sub-state until a leaf or a choice is reached.
+    std::vector<State*> path {};
+    path.push_back(state);
+
+    bool found_next = !state->is_choice;
+    while (found_next)
+    {
+        found_next = false;
+        for (auto i = 0u; i < reader.getStateCount(); i++)
+        {
+            auto tmp = reader.getState(i);
+            if ((state->id == tmp->parent) && ("initial" == tmp->name))
+            {
+                auto tr = reader.getTransitionFrom(tmp->id, 0);
+                if ((nullptr != tr) && (nullptr != reader.getStateById(tr->state_b)))
+                {
+                    state = reader.getStateById(tr->state_b);
+                    path.push_back(state);
+                    found_next = !state->is_choice;
+                }
+                break;
+            }
+        }
+    }
+
+    return path;
+}
+
+std::vector<State*> Analyzer::get_ancestors(State* state)
+{
+    std::vector<State*> ancestors {};
+    while (nullptr != state)
+    {
+        ancestors.push_back(state);
+        state = reader.getStateById(state->parent);
+    }
+    return ancestors;
+}
+
+std::vector<Transition*> Analyzer::get_choice_branches(State* choice)
+{
+    // the writer checks the guarded transitions in order, and uses the last unguarded one as default.
+    std::vector<Transition*> branches {};
+    Transition*              default_tr = nullptr;
+    for (auto j = 0u; j < reader.getTransitionCountFromStateId(choice->id); j++)
+    {
+        auto tr = reader.getTransitionFrom(choice->id, j);
+        if (tr->has_guard)
+        {
+            branches.push_back(tr);
+        }
+        else
+        {
+            default_tr = tr;
+        }
+    }
+    if (nullptr != default_tr)
+    {
+        branches.push_back(default_tr);
+    }
+    return branches;
+}
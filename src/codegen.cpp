@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <filesystem>
 #include <iostream>
+#include <string>
 #include <vector>
 
 #include "../include/reader.hpp"
@@ -16,6 +17,28 @@ void configure_default(WriterConfig& cfg, std::string& out)
     cfg.verbose = false;
     cfg.do_tracing = false;
     cfg.parent_first_execution = true;
+    cfg.lean_header = false;
+    cfg.shared_runtime = false;
+    cfg.strip_dead_code = false;
+    cfg.minimize = false;
+    cfg.wcet_report = false;
+    cfg.footprint = false;
+    cfg.instrument = false;
+    cfg.profile = "";
+    cfg.queue_capacity = 0;
+    cfg.queue_overflow = "";
+    cfg.ingress_capacity = 0;
+    cfg.deferred_dispatch = false;
+    cfg.table_backend = false;
+    cfg.flatten_dispatch = false;
+    cfg.event_switch = false;
+    cfg.tickless_timers = false;
+    cfg.compact_layout = false;
+    cfg.fleet = false;
+    cfg.fleet_snapshot = false;
+    cfg.timer_service = false;
+    cfg.trace_hook = TraceHook::Function;
+    cfg.trace_ring = false;
     out = "src/src-gen";
 }
 
@@ -28,15 +51,197 @@ void print_usage()
     std::cout << "\t-t\t\t\tGenerate tracing functions" << std::endl;
     std::cout << "\t-c\t\t\tChild first execution scheme" << std::endl;
     std::cout << "\t-o <folder>\tWhere to store the generated files" << std::endl;
-    std::cout << "\t-i <file>\tWhat file to generate" << std::endl << std::endl;
+    std::cout << "\t-i <file>\tWhat file to generate" << std::endl;
+    std::cout << "\t--lean-header\t\tOnly expose the public API in the generated header" << std::endl;
+    std::cout << "\t--runtime\t\tShare timers, queues and tracing types through plantgen_runtime.h" << std::endl;
+    std::cout << "\t--strip-dead\t\tLeave out unreachable states and transitions that can never fire" << std::endl;
+    std::cout << "\t--minimize\t\tMerge states with identical actions and transitions" << std::endl;
+    std::cout << "\t--wcet-report\t\tPrint the worst case steps needed to handle each event in each state" << std::endl;
+    std::cout << "\t--footprint\t\tWrite <model>.footprint.json with type sizes and code shape" << std::endl;
+    std::cout << "\t--instrument\t\tCount events and transitions, readable through get_profile()" << std::endl;
+    std::cout << "\t--profile=<file>\tCheck hot transitions first and mark hot and cold code using a profile"
+              << std::endl;
+    std::cout << "\t--queue-capacity=<n>\tUse fixed capacity event queues that never allocate" << std::endl;
+    std::cout << "\t--queue-overflow=<p>\tFull queue policy: assert, drop-newest, drop-oldest or return-false"
+              << std::endl;
+    std::cout << "\t--mpsc-ingress=<n>\tRaise in events from any thread into a lock-free queue, dispatched by drain()"
+              << std::endl;
+    std::cout << "\t--deferred\t\tRaising only queues events, process() and process_until() dispatch them"
+              << std::endl;
+    std::cout << "\t--backend=<b>\t\tDispatch with react functions (switch) or constant tables (table)" << std::endl;
+    std::cout << "\t--flatten\t\tCheck the transitions of all parents in the react function of each state"
+              << std::endl;
+    std::cout << "\t--event-switch\t\tSwitch on the event in react functions, grouping the guards of each event"
+              << std::endl;
+    std::cout << "\t--tickless\t\tSkip timers before the earliest deadline and generate next_timeout_ms()"
+              << std::endl;
+    std::cout << "\t--compact\t\tUse the narrowest enum types and pack the running flags of the timers"
+              << std::endl;
+    std::cout << "\t--fleet\t\t\tAlso generate <model>Fleet, storing many instances in one array per field"
+              << std::endl;
+    std::cout << "\t--fleet-snapshot\tAdd save() and restore() to the fleet, copying its arrays to and from a file"
+              << std::endl;
+    std::cout << "\t--timer-service\t\tSchedule timers on a shared TimerService of the runtime instead of ticking"
+              << std::endl;
+    std::cout << "\t--trace-hook=<h>\tTrace through std::function (function), function pointers (pointer)"
+              << " or PLANTGEN_TRACER (static)" << std::endl;
+    std::cout << "\t--trace-ring\t\tRecord binary trace records into a TraceRing of the runtime, see tracedump"
+              << std::endl
+              << std::endl;
     std::cout << "\tDefault values:" << std::endl;
     std::cout << "\t\tLong state names: disabled" << std::endl;
     std::cout << "\t\tVerbose output:   disabled" << std::endl;
     std::cout << "\t\tGenerate tracing: disabled" << std::endl;
     std::cout << "\t\tChild first exec: disabled" << std::endl;
+    std::cout << "\t\tLean header:      disabled" << std::endl;
+    std::cout << "\t\tShared runtime:   disabled" << std::endl;
+    std::cout << "\t\tStrip dead code:  disabled" << std::endl;
+    std::cout << "\t\tMinimize states:  disabled" << std::endl;
+    std::cout << "\t\tWCET report:      disabled" << std::endl;
+    std::cout << "\t\tFootprint report: disabled" << std::endl;
+    std::cout << "\t\tInstrumentation:  disabled" << std::endl;
+    std::cout << "\t\tProfile:          none" << std::endl;
+    std::cout << "\t\tQueue capacity:   unbounded, or as set in the diagram header" << std::endl;
+    std::cout << "\t\tQueue overflow:   assert, or as set in the diagram header" << std::endl;
+    std::cout << "\t\tMPSC ingress:     disabled" << std::endl;
+    std::cout << "\t\tDeferred events:  disabled" << std::endl;
+    std::cout << "\t\tBackend:          switch" << std::endl;
+    std::cout << "\t\tFlatten dispatch: disabled" << std::endl;
+    std::cout << "\t\tEvent switch:     disabled" << std::endl;
+    std::cout << "\t\tTickless timers:  disabled" << std::endl;
+    std::cout << "\t\tCompact layout:   disabled" << std::endl;
+    std::cout << "\t\tFleet container:  disabled" << std::endl;
+    std::cout << "\t\tFleet snapshots:  disabled" << std::endl;
+    std::cout << "\t\tTimer service:    disabled" << std::endl;
+    std::cout << "\t\tTrace hook:       function" << std::endl;
+    std::cout << "\t\tTrace ring:       disabled" << std::endl;
     std::cout << "\t\tOutput folder:    src/src-gen" << std::endl;
 }
 
+int parse_long_argument(const std::string& arg, WriterConfig& cfg)
+{
+    if ("--lean-header" == arg)
+    {
+        cfg.lean_header = true;
+    }
+    else if ("--runtime" == arg)
+    {
+        cfg.shared_runtime = true;
+    }
+    else if ("--strip-dead" == arg)
+    {
+        cfg.strip_dead_code = true;
+    }
+    else if ("--minimize" == arg)
+    {
+        cfg.minimize = true;
+    }
+    else if ("--wcet-report" == arg)
+    {
+        cfg.wcet_report = true;
+    }
+    else if ("--footprint" == arg)
+    {
+        cfg.footprint = true;
+    }
+    else if ("--instrument" == arg)
+    {
+        cfg.instrument = true;
+    }
+    else if (0 == arg.rfind("--profile=", 0))
+    {
+        cfg.profile = arg.substr(10);
+    }
+    else if (("--backend=switch" == arg) || ("--backend=table" == arg))
+    {
+        cfg.table_backend = ("--backend=table" == arg);
+    }
+    else if ("--flatten" == arg)
+    {
+        cfg.flatten_dispatch = true;
+    }
+    else if ("--event-switch" == arg)
+    {
+        cfg.event_switch = true;
+    }
+    else if ("--tickless" == arg)
+    {
+        cfg.tickless_timers = true;
+    }
+    else if ("--compact" == arg)
+    {
+        cfg.compact_layout = true;
+    }
+    else if ("--fleet" == arg)
+    {
+        cfg.fleet = true;
+    }
+    else if ("--fleet-snapshot" == arg)
+    {
+        cfg.fleet_snapshot = true;
+    }
+    else if ("--timer-service" == arg)
+    {
+        cfg.timer_service = true;
+    }
+    else if ("--trace-hook=function" == arg)
+    {
+        cfg.trace_hook = TraceHook::Function;
+    }
+    else if ("--trace-hook=pointer" == arg)
+    {
+        cfg.trace_hook = TraceHook::Pointer;
+    }
+    else if ("--trace-hook=static" == arg)
+    {
+        cfg.trace_hook = TraceHook::Static;
+    }
+    else if ("--trace-ring" == arg)
+    {
+        cfg.trace_ring = true;
+    }
+    else if ("--deferred" == arg)
+    {
+        cfg.deferred_dispatch = true;
+    }
+    else if (0 == arg.rfind("--queue-capacity=", 0))
+    {
+        const auto capacity = arg.substr(17);
+        if (capacity.empty() || (std::string::npos != capacity.find_first_not_of("0123456789")))
+        {
+            std::cout << "Queue capacity must be a number: " << arg << std::endl;
+            return 1;
+        }
+        cfg.queue_capacity = static_cast<size_t>(std::stoul(capacity));
+    }
+    else if (0 == arg.rfind("--queue-overflow=", 0))
+    {
+        QueueOverflow overflow {};
+        if (!Reader::parse_queue_overflow(arg.substr(17), overflow))
+        {
+            std::cout << "Unknown queue overflow policy: " << arg << std::endl;
+            return 1;
+        }
+        cfg.queue_overflow = arg.substr(17);
+    }
+    else if (0 == arg.rfind("--mpsc-ingress=", 0))
+    {
+        const auto capacity = arg.substr(15);
+        if (capacity.empty() || (std::string::npos != capacity.find_first_not_of("0123456789")))
+        {
+            std::cout << "Ingress capacity must be a number: " << arg << std::endl;
+            return 1;
+        }
+        cfg.ingress_capacity = static_cast<size_t>(std::stoul(capacity));
+    }
+    else
+    {
+        std::cout << "Unknown parameter given: " << arg << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
 int parse_arguments(int argc, char* argv[], WriterConfig& cfg, std::string& in, std::string& out)
 {
     for (auto i = 0; i < argc; i++)
@@ -97,6 +302,14 @@ int parse_arguments(int argc, char* argv[], WriterConfig& cfg, std::string& in,
                 case 'h':
                     print_usage();
                     return 1;
+
+                case '-':
+                    if (0 != parse_long_argument(argv[i], cfg))
+                    {
+                        print_usage();
+                        return 1;
+                    }
+                    break;
             }
         }
     }
@@ -119,6 +332,37 @@ int main(int argc, char* argv[])
         print_usage();
         return 1;
     }
+    else if (cfg.fleet && cfg.lean_header)
+    {
+        // the fleet reaches into the private fields of the machine, which the lean header hides.
+        std::cout << "--fleet can not be combined with --lean-header" << std::endl;
+        return 1;
+    }
+    else if (cfg.fleet_snapshot && !cfg.fleet)
+    {
+        std::cout << "--fleet-snapshot requires --fleet" << std::endl;
+        return 1;
+    }
+    else if (cfg.timer_service && (!cfg.shared_runtime || cfg.fleet || cfg.lean_header || cfg.tickless_timers))
+    {
+        // the service lives in the runtime, and wakes whole machines rather than a fleet or a lean interface. It
+        // keeps the deadlines itself, so there is no tick to skip.
+        std::cout << "--timer-service requires --runtime, and can not be combined with --fleet, --lean-header or "
+                     "--tickless"
+                  << std::endl;
+        return 1;
+    }
+    else if ((TraceHook::Function != cfg.trace_hook) && !cfg.do_tracing)
+    {
+        std::cout << "--trace-hook requires -t" << std::endl;
+        return 1;
+    }
+    else if (cfg.trace_ring && (!cfg.shared_runtime || cfg.fleet))
+    {
+        // the ring lives in the runtime, and the fleet dispatches without the machine functions that record.
+        std::cout << "--trace-ring requires --runtime, and can not be combined with --fleet" << std::endl;
+        return 1;
+    }
 
     // append slash if non-existing on outdir
     if ('/' != outdir.back())
@@ -0,0 +1,544 @@
+/** @file
+ *  @brief Implementation of the footprint report writer.
+ */
+
+#include "../include/footprint.hpp"
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+Footprint::Footprint(Reader& reader, const WriterConfig& config, const size_t queue_capacity) :
+    reader(reader),
+    config(config),
+    queue_capacity(queue_capacity),
+    functions()
+{
+}
+
+TypeLayout Footprint::get_builtin_layout(const std::string& type)
+{
+    static const std::map<std::string, size_t> sizes {
+        { "bool", 1 },
+        { "char", 1 },
+        { "signed char", 1 },
+        { "unsigned char", 1 },
+        { "int8_t", 1 },
+        { "uint8_t", 1 },
+        { "short", 2 },
+        { "unsigned short", 2 },
+        { "int16_t", 2 },
+        { "uint16_t", 2 },
+        { "int", 4 },
+        { "unsigned", 4 },
+        { "unsigned int", 4 },
+        { "int32_t", 4 },
+        { "uint32_t", 4 },
+        { "float", 4 },
+        { "long", 8 },
+        { "unsigned long", 8 },
+        { "long long", 8 },
+        { "unsigned long long", 8 },
+        { "int64_t", 8 },
+        { "uint64_t", 8 },
+        { "double", 8 },
+        { "size_t", 8 },
+        { "ptrdiff_t", 8 },
+        { "intptr_t", 8 },
+        { "uintptr_t", 8 },
+        { "long double", 16 },
+    };
+
+    // drop qualifiers and the std prefix, these do not change the size.
+    std::istringstream iss(type);
+    std::string        token {};
+    std::string        name {};
+    while (iss >> token)
+    {
+        if (("const" != token) && ("volatile" != token))
+        {
+            name += (name.empty() ? "" : " ") + token;
+        }
+    }
+    if (0 == name.rfind("std::", 0))
+    {
+        name = name.substr(5);
+    }
+
+    TypeLayout layout {};
+    if (!name.empty() && ('*' == name.back()))
+    {
+        layout.size  = 8;
+        layout.align = 8;
+    }
+    else if (sizes.end() != sizes.find(name))
+    {
+        layout.size  = sizes.at(name);
+        layout.align = layout.size;
+    }
+    else
+    {
+        layout.is_known = false;
+    }
+    return layout;
+}
+
+TypeLayout Footprint::get_struct_layout(const std::vector<TypeLayout>& members)
+{
+    TypeLayout layout {};
+    for (const auto& member : members)
+    {
+        layout.is_known = layout.is_known && member.is_known;
+        layout.align    = std::max(layout.align, member.align);
+        layout.size     = ((layout.size + member.align - 1) / member.align) * member.align + member.size;
+    }
+    // an empty struct still takes a byte, and the size is padded to the alignment.
+    layout.size = std::max<size_t>(layout.size, 1);
+    layout.size = ((layout.size + layout.align - 1) / layout.align) * layout.align;
+    return layout;
+}
+
+TypeLayout Footprint::get_union_layout(const std::vector<TypeLayout>& members)
+{
+    TypeLayout layout {};
+    for (const auto& member : members)
+    {
+        layout.is_known = layout.is_known && member.is_known;
+        layout.align    = std::max(layout.align, member.align);
+        layout.size     = std::max(layout.size, member.size);
+    }
+    layout.size = std::max<size_t>(layout.size, 1);
+    layout.size = ((layout.size + layout.align - 1) / layout.align) * layout.align;
+    return layout;
+}
+
+TypeLayout Footprint::get_enum_layout(const size_t count) const
+{
+    // the generated enums have no explicit underlying type, which makes them an int, unless compact.
+    if (config.compact_layout)
+    {
+        return get_builtin_layout((count <= 256) ? "uint8_t" : "uint16_t");
+    }
+    return get_builtin_layout("int");
+}
+
+TypeLayout Footprint::get_array_layout(const TypeLayout& item, const size_t count)
+{
+    TypeLayout layout = item;
+    layout.size       = item.size * count;
+    return layout;
+}
+
+TypeLayout Footprint::get_event_data_layout()
+{
+    std::vector<TypeLayout> members {};
+    for (auto i = 0u; i < reader.getInEventCount(); i++)
+    {
+        auto ev = reader.getInEvent(i);
+        if ((nullptr != ev) && ev->require_parameter && ("null" != ev->name))
+        {
+            members.push_back(get_builtin_layout(ev->parameter_type));
+        }
+    }
+    for (auto i = 0u; i < reader.getInternalEventCount(); i++)
+    {
+        auto ev = reader.getInternalEvent(i);
+        if ((nullptr != ev) && ev->require_parameter && ("null" != ev->name))
+        {
+            members.push_back(get_builtin_layout(ev->parameter_type));
+        }
+    }
+    if (members.empty())
+    {
+        return TypeLayout();
+    }
+    return get_union_layout(members);
+}
+
+TypeLayout Footprint::get_event_layout()
+{
+    if ((0 == reader.getInEventCount()) && (0 == reader.getTimeEventCount()) && (0 == reader.getInternalEventCount()))
+    {
+        return TypeLayout();
+    }
+    const auto n_events = reader.getInEventCount() + reader.getTimeEventCount() + reader.getInternalEventCount();
+    std::vector<TypeLayout> members { get_enum_layout(n_events) };
+    const auto              data = get_event_data_layout();
+    if (0 < data.size)
+    {
+        members.push_back(data);
+    }
+    return get_struct_layout(members);
+}
+
+TypeLayout Footprint::get_out_event_data_layout()
+{
+    std::vector<TypeLayout> members {};
+    for (auto i = 0u; i < reader.getOutEventCount(); i++)
+    {
+        auto ev = reader.getOutEvent(i);
+        if ((nullptr != ev) && ev->require_parameter && ("null" != ev->name))
+        {
+            members.push_back(get_builtin_layout(ev->parameter_type));
+        }
+    }
+    if (members.empty())
+    {
+        return TypeLayout();
+    }
+    return get_union_layout(members);
+}
+
+TypeLayout Footprint::get_out_event_layout()
+{
+    if (0 == reader.getOutEventCount())
+    {
+        return TypeLayout();
+    }
+    std::vector<TypeLayout> members { get_enum_layout(reader.getOutEventCount()) };
+    const auto              data = get_out_event_data_layout();
+    if (0 < data.size)
+    {
+        members.push_back(data);
+    }
+    return get_struct_layout(members);
+}
+
+TypeLayout Footprint::get_time_events_layout()
+{
+    if (0 == reader.getTimeEventCount())
+    {
+        return TypeLayout();
+    }
+    const auto n_time = reader.getTimeEventCount();
+    const auto flag   = get_builtin_layout("bool");
+    const auto time   = get_builtin_layout("size_t");
+    if (config.compact_layout && (n_time <= 64))
+    {
+        // one integer of running flags, followed by the expire times.
+        const auto              bits = (n_time <= 8) ? 1 : ((n_time <= 16) ? 2 : ((n_time <= 32) ? 4 : 8));
+        std::vector<TypeLayout> members(n_time + 1, time);
+        members[0].size  = bits;
+        members[0].align = bits;
+        return get_struct_layout(members);
+    }
+
+    // same members as the generated TimeEvent, two flags followed by the timeout and the expire time.
+    const auto              timer = get_struct_layout({ flag, flag, time, time });
+    std::vector<TypeLayout> members(n_time, timer);
+    return get_struct_layout(members);
+}
+
+TypeLayout Footprint::get_variables_layout()
+{
+    std::vector<TypeLayout> internal {};
+    for (auto i = 0u; i < reader.getPrivateVariableCount(); i++)
+    {
+        internal.push_back(get_builtin_layout(reader.getPrivateVariable(i)->type));
+    }
+    std::vector<TypeLayout> exported {};
+    for (auto i = 0u; i < reader.getPublicVariableCount(); i++)
+    {
+        exported.push_back(get_builtin_layout(reader.getPublicVariable(i)->type));
+    }
+
+    std::vector<TypeLayout> members {};
+    if (!internal.empty())
+    {
+        members.push_back(get_struct_layout(internal));
+    }
+    if (!exported.empty())
+    {
+        members.push_back(get_struct_layout(exported));
+    }
+    if (members.empty())
+    {
+        return TypeLayout();
+    }
+    return get_struct_layout(members);
+}
+
+TypeLayout Footprint::get_queue_layout(const TypeLayout& item) const
+{
+    const auto count = get_builtin_layout("size_t");
+    if (0 < queue_capacity)
+    {
+        // the items of the ring, followed by the head and the count.
+        return get_struct_layout({ get_array_layout(item, queue_capacity), count, count });
+    }
+
+    // a std::deque of libstdc++ keeps a map pointer, its size and two iterators of four pointers.
+    return get_array_layout(get_builtin_layout("void*"), 10);
+}
+
+TypeLayout Footprint::get_ingress_layout()
+{
+    size_t capacity = 1;
+    while (capacity < config.ingress_capacity)
+    {
+        capacity *= 2;
+    }
+    const auto cell = get_struct_layout({ get_builtin_layout("size_t"), get_event_layout() });
+
+    // the tail and the head sit on cache lines of their own.
+    TypeLayout index = get_builtin_layout("size_t");
+    index.align      = 64;
+    return get_struct_layout({ get_array_layout(cell, capacity), index, index });
+}
+
+TypeLayout Footprint::get_machine_layout()
+{
+    const auto n_events = reader.getInEventCount() + reader.getTimeEventCount() + reader.getInternalEventCount();
+    size_t     n_states = 0;
+    for (auto i = 0u; i < reader.getStateCount(); i++)
+    {
+        auto state = reader.getState(i);
+        if (!state->is_choice && ("initial" != state->name) && ("final" != state->name))
+        {
+            n_states++;
+        }
+    }
+
+    // same members, in the same order, as the generated state machine class.
+    std::vector<TypeLayout> members {};
+    if (config.timer_service && (0 < reader.getTimeEventCount()))
+    {
+        // the virtual table pointer of the TimerClient base.
+        members.push_back(get_builtin_layout("void*"));
+    }
+    members.push_back(get_enum_layout(n_states));
+    if (0 < reader.getTimeEventCount())
+    {
+        members.push_back(get_time_events_layout());
+    }
+    if (0 < n_events)
+    {
+        members.push_back(get_queue_layout(get_event_layout()));
+    }
+    if (0 < reader.getOutEventCount())
+    {
+        members.push_back(get_queue_layout(get_out_event_layout()));
+    }
+    if ((0 < config.ingress_capacity) && (0 < reader.getInEventCount()))
+    {
+        members.push_back(get_ingress_layout());
+    }
+    if (0 < reader.get_variable_count())
+    {
+        members.push_back(get_variables_layout());
+    }
+    if (config.do_tracing && (TraceHook::Function == config.trace_hook))
+    {
+        // a std::function of libstdc++ is two words of storage and two function pointers.
+        members.push_back(get_array_layout(get_builtin_layout("void*"), 4));
+        members.push_back(get_array_layout(get_builtin_layout("void*"), 4));
+    }
+    else if (config.do_tracing && (TraceHook::Pointer == config.trace_hook))
+    {
+        // a function pointer and a context pointer for each hook, the static tracer has no storage.
+        members.push_back(get_array_layout(get_builtin_layout("void*"), 4));
+    }
+    if (config.trace_ring)
+    {
+        members.push_back(get_builtin_layout("void*"));
+        members.push_back(get_builtin_layout("uint16_t"));
+    }
+    if (0 < reader.getTimeEventCount())
+    {
+        if (!config.timer_service)
+        {
+            members.push_back(get_builtin_layout("size_t"));
+        }
+        if (config.tickless_timers)
+        {
+            members.push_back(get_builtin_layout("size_t"));
+        }
+        if (config.timer_service)
+        {
+            members.push_back(get_builtin_layout("void*"));
+        }
+    }
+    members.push_back(get_event_layout());
+    if (config.instrument)
+    {
+        size_t n_transitions = 0;
+        for (auto i = 0u; i < reader.getTransitionCount(); i++)
+        {
+            auto tr     = reader.getTransition(i);
+            auto source = reader.getStateById(tr->state_a);
+            if ((nullptr != source) && ("initial" != source->name) && !source->is_choice && ("null" != tr->event.name))
+            {
+                n_transitions++;
+            }
+        }
+        members.push_back(get_array_layout(get_builtin_layout("size_t"), n_states));
+        if (0 < n_transitions)
+        {
+            members.push_back(get_array_layout(get_builtin_layout("size_t"), n_transitions));
+        }
+    }
+    return get_struct_layout(members);
+}
+
+size_t Footprint::get_max_react_depth()
+{
+    // every react function calls the one of its parent, so the depth is the nesting of the state.
+    size_t max_depth = 0;
+    for (auto i = 0u; i < reader.getStateCount(); i++)
+    {
+        size_t depth = 0;
+        for (auto state = reader.getState(i); nullptr != state; state = reader.getStateById(state->parent))
+        {
+            depth++;
+        }
+        max_depth = std::max(max_depth, depth);
+    }
+    return max_depth;
+}
+
+void Footprint::add_function(const std::string& name, const std::vector<std::string>& states, const std::string& body)
+{
+    FunctionShape shape {};
+    shape.name   = name;
+    shape.states = states;
+
+    // length of the if / else if chain open at each indentation.
+    std::map<size_t, size_t> chains {};
+    std::istringstream       iss(body);
+    std::string              line {};
+    while (std::getline(iss, line))
+    {
+        shape.lines++;
+        const auto start = line.find_first_not_of(' ');
+        if (std::string::npos == start)
+        {
+            continue;
+        }
+        if (0 == line.compare(start, 4, "if ("))
+        {
+            shape.branches++;
+            chains[start] = 1;
+        }
+        else if (0 == line.compare(start, 9, "else if ("))
+        {
+            shape.branches++;
+            chains[start]++;
+        }
+        else if ("else" == line.substr(start))
+        {
+            shape.branches++;
+        }
+        shape.max_chain = std::max(shape.max_chain, chains[start]);
+    }
+    functions.push_back(shape);
+}
+
+void Footprint::write_size(std::ostream& out, const std::string& name, const TypeLayout& layout, const bool is_last)
+{
+    out << "    \"" << name << "\": ";
+    if (layout.is_known)
+    {
+        out << layout.size;
+    }
+    else
+    {
+        out << "null";
+    }
+    out << (is_last ? "" : ",") << std::endl;
+}
+
+bool Footprint::generate(const std::string& path)
+{
+    std::ofstream out {};
+    out.open(path);
+    if (!out.is_open())
+    {
+        std::cout << "ERR: Failed to open " << path << std::endl;
+        return false;
+    }
+
+    size_t n_states  = 0;
+    size_t n_choices = 0;
+    for (auto i = 0u; i < reader.getStateCount(); i++)
+    {
+        auto state = reader.getState(i);
+        if (state->is_choice)
+        {
+            n_choices++;
+        }
+        else if (("initial" != state->name) && ("final" != state->name))
+        {
+            n_states++;
+        }
+    }
+
+    // the reader keeps a placeholder null event for transitions without a trigger.
+    auto count_events = [](size_t n, const std::function<Event*(size_t)>& get_event)
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            count += ("null" != get_event(i)->name) ? 1 : 0;
+        }
+        return count;
+    };
+    const auto n_in = count_events(reader.getInEventCount(), [this](size_t i) { return reader.getInEvent(i); });
+    const auto n_out = count_events(reader.getOutEventCount(), [this](size_t i) { return reader.getOutEvent(i); });
+    const auto n_internal
+        = count_events(reader.getInternalEventCount(), [this](size_t i) { return reader.getInternalEvent(i); });
+    const auto n_time = count_events(reader.getTimeEventCount(), [this](size_t i) { return reader.getTimeEvent(i); });
+
+    size_t max_chain = 0;
+    for (const auto& fn : functions)
+    {
+        max_chain = std::max(max_chain, fn.max_chain);
+    }
+
+    out << "{" << std::endl;
+    out << "  \"model\": \"" << reader.get_model_name() << "\"," << std::endl;
+    out << "  \"states\": " << n_states << "," << std::endl;
+    out << "  \"choices\": " << n_choices << "," << std::endl;
+    out << "  \"events\": {" << std::endl;
+    out << "    \"in\": " << n_in << "," << std::endl;
+    out << "    \"out\": " << n_out << "," << std::endl;
+    out << "    \"internal\": " << n_internal << "," << std::endl;
+    out << "    \"time\": " << n_time << std::endl;
+    out << "  }," << std::endl;
+    out << "  \"timers\": " << n_time << "," << std::endl;
+
+    // sizes are estimated for a 64 bit target, types that are not generated are 0 and unknown types null.
+    out << "  \"sizes\": {" << std::endl;
+    write_size(out, "Event", get_event_layout(), false);
+    write_size(out, "EventData", get_event_data_layout(), false);
+    write_size(out, "OutEvent", get_out_event_layout(), false);
+    write_size(out, "OutEventData", get_out_event_data_layout(), false);
+    write_size(out, "TimeEvents", get_time_events_layout(), false);
+    write_size(out, "Variables", get_variables_layout(), false);
+    write_size(out, "Machine", get_machine_layout(), true);
+    out << "  }," << std::endl;
+
+    out << "  \"max_react_depth\": " << get_max_react_depth() << "," << std::endl;
+    out << "  \"max_if_chain\": " << max_chain << "," << std::endl;
+    out << "  \"react_functions\": [" << std::endl;
+    for (size_t i = 0; i < functions.size(); i++)
+    {
+        const auto& fn = functions[i];
+        out << "    { \"name\": \"" << fn.name << "\", \"states\": [";
+        for (size_t j = 0; j < fn.states.size(); j++)
+        {
+            out << (0 == j ? "" : ", ") << "\"" << fn.states[j] << "\"";
+        }
+        out << "], \"lines\": " << fn.lines << ", \"branches\": " << fn.branches
+            << ", \"max_if_chain\": " << fn.max_chain << " }" << ((i + 1) < functions.size() ? "," : "")
+            << std::endl;
+    }
+    out << "  ]" << std::endl;
+    out << "}" << std::endl;
+
+    out.close();
+    return true;
+}
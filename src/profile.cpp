@@ -0,0 +1,80 @@
+/** @file
+ *  @brief Implementation of the profile reader.
+ */
+
+#include "../include/profile.hpp"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+Profile::Profile() : states(), transitions(), is_loaded() {}
+
+bool Profile::load(const std::string& filename)
+{
+    std::ifstream in(filename);
+    if (!in.is_open())
+    {
+        return false;
+    }
+
+    // each line is "<count> state <name>" or "<count> transition <key>".
+    std::string line {};
+    while (std::getline(in, line))
+    {
+        std::istringstream iss(line);
+        size_t             count {};
+        std::string        kind {};
+        if (!(iss >> count >> kind))
+        {
+            continue;
+        }
+
+        std::string name {};
+        std::getline(iss >> std::ws, name);
+        if ("state" == kind)
+        {
+            states[name] += count;
+        }
+        else if ("transition" == kind)
+        {
+            transitions[name] += count;
+        }
+    }
+
+    is_loaded = true;
+    return true;
+}
+
+bool Profile::has_data() const
+{
+    return is_loaded;
+}
+
+size_t Profile::get_state_count(const std::string& name) const
+{
+    auto it = states.find(name);
+    return (states.end() == it) ? 0 : it->second;
+}
+
+size_t Profile::get_transition_count(const std::string& key) const
+{
+    auto it = transitions.find(key);
+    return (transitions.end() == it) ? 0 : it->second;
+}
+
+std::string Profile::get_transition_key(Reader& reader, const Transition* tr)
+{
+    auto source = reader.getStateById(tr->state_a);
+    auto target = reader.getStateById(tr->state_b);
+
+    std::string key = (nullptr == source) ? "null" : source->name;
+    key += " -> ";
+    key += (nullptr == target) ? "null" : target->name;
+    key += " : " + tr->event.name;
+    if (tr->has_guard)
+    {
+        key += " [" + tr->guard + "]";
+    }
+    return key;
+}
@@ -4,14 +4,22 @@
 
 #include <algorithm>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <string>
 #include <vector>
 
 #include "../include/reader.hpp"
 
-Reader::Reader(const std::string& filename, const bool v) : verbose(v)
+Reader::Reader(const std::string& filename, const bool v) : Reader(filename, v, 0) {}
+
+Reader::Reader(const std::string& filename, const bool v, const size_t depth) :
+    verbose(v), nesting(depth), queue_capacity(), queue_overflow(QueueOverflow::Assert)
 {
+    // submachine files are relative to the file referencing them.
+    const auto slash = filename.find_last_of('/');
+    directory        = (std::string::npos == slash) ? "" : filename.substr(0, slash + 1);
+
     in.open(filename);
     if (!in.is_open())
     {
@@ -23,6 +31,10 @@ Reader::Reader(const std::string& filename, const bool v) : verbose(v)
         auto index = filename.find_last_of('.');
         model_name = filename.substr(0, index);
         collect_states();
+        for (const auto& submachine : submachines)
+        {
+            inline_submachine(submachine);
+        }
     }
 }
 
@@ -36,6 +48,34 @@ std::string Reader::get_model_name() const
     return model_name;
 }
 
+size_t Reader::get_queue_capacity() const
+{
+    return queue_capacity;
+}
+
+QueueOverflow Reader::get_queue_overflow() const
+{
+    return queue_overflow;
+}
+
+bool Reader::parse_queue_overflow(const std::string& str, QueueOverflow& overflow)
+{
+    static const std::map<std::string, QueueOverflow> policies {
+        { "assert", QueueOverflow::Assert },
+        { "drop-newest", QueueOverflow::DropNewest },
+        { "drop-oldest", QueueOverflow::DropOldest },
+        { "return-false", QueueOverflow::ReturnFalse },
+    };
+
+    const auto policy = policies.find(str);
+    if (policies.end() == policy)
+    {
+        return false;
+    }
+    overflow = policy->second;
+    return true;
+}
+
 size_t Reader::get_uml_line_count() const
 {
     return uml.size();
@@ -312,6 +352,20 @@ Event* Reader::getOutEvent(size_t id)
     return nullptr;
 }
 
+size_t Reader::getTransitionCount() const
+{
+    return transitions.size();
+}
+
+Transition* Reader::getTransition(const size_t id)
+{
+    if (id < transitions.size())
+    {
+        return &transitions[id];
+    }
+    return nullptr;
+}
+
 size_t Reader::getTransitionCountFromStateId(StateId id) const
 {
     size_t n = 0;
@@ -379,6 +433,50 @@ StateDeclaration* Reader::getDeclFromStateId(StateId state_id, Declaration type,
     return nullptr;
 }
 
+void Reader::remove_state(const StateId id)
+{
+    states.erase(
+            std::remove_if(
+                    states.begin(),
+                    states.end(),
+                    [id](const State& s)
+                    {
+                        return id == s.id;
+                    }),
+            states.end());
+
+    state_declarations.erase(
+            std::remove_if(
+                    state_declarations.begin(),
+                    state_declarations.end(),
+                    [id](const StateDeclaration& d)
+                    {
+                        return id == d.state_id;
+                    }),
+            state_declarations.end());
+}
+
+void Reader::remove_transition(const size_t id)
+{
+    if (id < transitions.size())
+    {
+        transitions.erase(transitions.begin() + static_cast<std::ptrdiff_t>(id));
+    }
+}
+
+void Reader::remove_event(const std::string& name)
+{
+    events.erase(
+            std::remove_if(
+                    events.begin(),
+                    events.end(),
+                    [&name](const Event& e)
+                    {
+                        return name == e.name;
+                    }),
+            events.end());
+}
+
 bool Reader::is_tr_arrow(const std::string& token)
 {
     return ('-' == token.front()) && ('>' == token.back());
@@ -466,6 +564,28 @@ void Reader::collect_states()
                         }
                         add_import(newImport);
                     }
+                    else if (("submachine" == tokens[0]) && (4 == tokens.size()) && (":" == tokens[2]))
+                    {
+                        Submachine submachine {};
+                        submachine.state    = tokens[1];
+                        submachine.filename = tokens[3];
+                        submachines.push_back(submachine);
+                    }
+                    else if (("queue" == tokens[0]) && ((2 == tokens.size()) || (3 == tokens.size())))
+                    {
+                        if (std::string::npos != tokens[1].find_first_not_of("0123456789"))
+                        {
+                            std::cout << "ERR: Queue capacity " << tokens[1] << " is not a number." << std::endl;
+                        }
+                        else
+                        {
+                            queue_capacity = static_cast<size_t>(std::stoul(tokens[1]));
+                        }
+                        if ((3 == tokens.size()) && !parse_queue_overflow(tokens[2], queue_overflow))
+                        {
+                            std::cout << "ERR: Unknown queue overflow policy " << tokens[2] << "." << std::endl;
+                        }
+                    }
                     else if ((("private" == tokens[0]) || ("public" == tokens[0])) && (5 <= tokens.size()))
                     {
                         Variable newVariable {};
@@ -822,6 +942,156 @@ void Reader::collect_states()
     }
 }
 
+void Reader::inline_submachine(const Submachine& submachine)
+{
+    StateId target = 0;
+    for (const auto& state : states)
+    {
+        if ((submachine.state == state.name) && ("initial" != state.name) && ("final" != state.name))
+        {
+            target = state.id;
+            break;
+        }
+    }
+    if (0 == target)
+    {
+        std::cout << "ERR: Submachine state " << submachine.state << " is not defined." << std::endl;
+        return;
+    }
+
+    // a diagram that includes itself would never end.
+    if (8 <= nesting)
+    {
+        std::cout << "ERR: Submachine " << submachine.filename << " is nested too deep." << std::endl;
+        return;
+    }
+
+    const auto    path = ('/' == submachine.filename.front()) ? submachine.filename : directory + submachine.filename;
+    std::ifstream probe(path);
+    if (!probe.is_open())
+    {
+        std::cout << "ERR: Failed to open submachine " << path << std::endl;
+        return;
+    }
+    probe.close();
+
+    Reader     sub(path, verbose, nesting + 1);
+    const auto prefix = submachine.state + "_";
+
+    // states are prefixed with the submachine state, its top level states become children of it.
+    std::map<StateId, StateId> ids {};
+    bool                       added = true;
+    while (added)
+    {
+        added = false;
+        for (const auto& state : sub.states)
+        {
+            if ((ids.end() == ids.find(state.id)) && ((0 == state.parent) || (ids.end() != ids.find(state.parent))))
+            {
+                const bool isPseudo = ("initial" == state.name) || ("final" == state.name);
+
+                State newState {};
+                newState.name      = isPseudo ? state.name : prefix + state.name;
+                newState.parent    = (0 == state.parent) ? target : ids[state.parent];
+                newState.is_choice = state.is_choice;
+                ids[state.id]      = add_state(newState);
+                added              = true;
+            }
+        }
+    }
+
+    for (auto var : sub.variables)
+    {
+        var.name = prefix + var.name;
+        add_variable(var);
+    }
+
+    for (const auto& imp : sub.imports)
+    {
+        const bool isFound = imports.end()
+                             != std::find_if(
+                                     imports.begin(),
+                                     imports.end(),
+                                     [&imp](const Import& i)
+                                     {
+                                         return imp.name == i.name;
+                                     });
+        if (!isFound)
+        {
+            add_import(imp);
+        }
+    }
+
+    // events are shared by name, so the parent can react on events raised by the submachine.
+    for (auto ev : sub.events)
+    {
+        if (ev.is_time_event)
+        {
+            // time events are named after their source state.
+            ev.name = prefix + ev.name;
+        }
+        auto existing = findEvent(ev.name);
+        if (nullptr == existing)
+        {
+            add_event(ev);
+        }
+        else if ((EventDirection::Incoming != ev.direction) && (EventDirection::Incoming == existing->direction))
+        {
+            // raised inside the composite, so the parent transitions on it were not meant for the outside. This
+            // holds for an out event of the submachine too, which must be queued rather than re-enter the cycle.
+            existing->direction = EventDirection::Internal;
+            for (auto& tr : transitions)
+            {
+                if (ev.name == tr.event.name)
+                {
+                    tr.event.direction = EventDirection::Internal;
+                }
+            }
+        }
+    }
+
+    for (auto tr : sub.transitions)
+    {
+        tr.state_a = ids[tr.state_a];
+        tr.state_b = ids[tr.state_b];
+        tr.guard   = rename_variables(tr.guard, sub.variables, prefix);
+        if (tr.event.is_time_event)
+        {
+            tr.event.name = prefix + tr.event.name;
+        }
+        add_transition(tr);
+    }
+
+    for (auto decl : sub.state_declarations)
+    {
+        decl.state_id    = ids[decl.state_id];
+        decl.declaration = rename_variables(decl.declaration, sub.variables, prefix);
+        add_declaration(decl);
+    }
+
+    if (verbose)
+    {
+        std::cout << "Inlined submachine " << path << " into state " << submachine.state << std::endl;
+    }
+}
+
+std::string Reader::rename_variables(const std::string&           str,
+                                     const std::vector<Variable>& vars,
+                                     const std::string&           prefix)
+{
+    std::string result = str;
+    for (const auto& var : vars)
+    {
+        const auto from = "${" + var.name + "}";
+        const auto to   = "${" + prefix + var.name + "}";
+        for (auto pos = result.find(from); std::string::npos != pos; pos = result.find(from, pos + to.size()))
+        {
+            result.replace(pos, from.size(), to);
+        }
+    }
+    return result;
+}
+
 StateId Reader::add_state(State newState)
 {
     static StateId id {};
@@ -0,0 +1,649 @@
+/** @file
+ *  @brief Implementation of the runtime support header writer.
+ */
+
+#include "../include/runtime.hpp"
+#include <fstream>
+#include <iostream>
+#include <string>
+
+std::string Runtime::get_filename()
+{
+    return "plantgen_runtime.h";
+}
+
+std::string Runtime::get_namespace()
+{
+    return "plantgen";
+}
+
+bool Runtime::generate(const std::string& outdir)
+{
+    std::ofstream out {};
+    out.open(outdir + get_filename());
+    if (!out.is_open())
+    {
+        std::cout << "ERR: Failed to open " << outdir << get_filename() << std::endl;
+        return false;
+    }
+
+    out << "/** @file" << std::endl;
+    out << " *  @brief Runtime support shared by all generated state machines." << std::endl;
+    out << " *" << std::endl;
+    out << " *  Generated by codegen, all models generated into the same folder share this file." << std::endl;
+    out << " */" << std::endl << std::endl;
+
+    out << "#pragma once" << std::endl << std::endl;
+    out << "#include <atomic>" << std::endl;
+    out << "#include <chrono>" << std::endl;
+    out << "#include <cstddef>" << std::endl;
+    out << "#include <cstdint>" << std::endl;
+    out << "#include <cstdio>" << std::endl;
+    out << "#include <deque>" << std::endl;
+    out << "#include <functional>" << std::endl;
+    out << "#include <memory>" << std::endl;
+    out << "#include <utility>" << std::endl;
+    out << "#include <vector>" << std::endl << std::endl;
+
+    out << "#define PLANTGEN_RUNTIME_VERSION " << version << std::endl << std::endl;
+
+    out << "namespace " << get_namespace() << std::endl;
+    out << "{" << std::endl;
+    write_timers(out);
+    write_timer_service(out);
+    write_queues(out);
+    write_tracing(out);
+    write_trace_ring(out);
+    out << "}" << std::endl;
+
+    out.close();
+    return true;
+}
+
+void Runtime::write_timers(std::ofstream& out)
+{
+    out << R"(    ///\brief Timer record of a single time event.
+    struct TimeEvent
+    {
+        bool is_started {};
+        bool is_periodic {};
+        size_t timeout_ms {};
+        size_t expire_time_ms {};
+    };
+
+    ///\brief Arms the timer to expire timeout_ms after now_ms.
+    inline void start_timer(TimeEvent& timer, size_t now_ms, size_t timeout_ms, bool periodic)
+    {
+        timer.timeout_ms = timeout_ms;
+        timer.expire_time_ms = now_ms + timeout_ms;
+        timer.is_periodic = periodic;
+        timer.is_started = true;
+    }
+
+    ///\brief Disarms the timer.
+    inline void stop_timer(TimeEvent& timer)
+    {
+        timer.is_started = false;
+    }
+
+    ///\brief Returns true if the timer expired at now_ms, periodic timers are reloaded and others disarmed.
+    inline bool expire_timer(TimeEvent& timer, size_t now_ms)
+    {
+        if (!timer.is_started || (now_ms < timer.expire_time_ms))
+        {
+            return false;
+        }
+        if (timer.is_periodic)
+        {
+            timer.expire_time_ms += timer.timeout_ms;
+        }
+        else
+        {
+            timer.is_started = false;
+        }
+        return true;
+    }
+
+)";
+}
+
+void Runtime::write_timer_service(std::ofstream& out)
+{
+    out << R"(    ///\brief Machine woken by a TimerService when one of its timers is due.
+    class TimerClient
+    {
+    public:
+        ///\brief Called by TimerService::advance() at the deadline the timer was scheduled for.
+        virtual void on_timer(size_t timer) = 0;
+
+    protected:
+        ~TimerClient() = default;
+    };
+
+    ///\brief Hierarchical timing wheel shared by many machines, which only wakes the machines with a due timer.
+    ///
+    /// Four levels of 64 slots cover about 4.6 hours at a resolution of 1 ms, later deadlines wait in an overflow
+    /// list. Advancing the time jumps straight to the next occupied slot, so idle time costs almost nothing.
+    /// Machines cancel the entry of every timer they stop, and all of their entries when they are destroyed.
+    ///
+    /// Each timer fires at its exact deadline, also when one advance() spans several deadlines. A timer restarted
+    /// by its own transition can therefore fire again within the same advance(), where time_tick() of a machine
+    /// without the service fires it at most once per tick.
+    class TimerService
+    {
+    private:
+        static constexpr size_t levels = 4;
+        static constexpr size_t slot_bits = 6;
+        static constexpr size_t slots = size_t(1) << slot_bits;
+
+        struct Entry
+        {
+            TimerClient* client;
+            size_t timer;
+            size_t deadline_ms;
+        };
+
+        std::vector<Entry> wheel[levels][slots];
+        uint64_t occupied[levels] {};
+        std::vector<Entry> overflow;
+        std::vector<Entry> due;
+        std::vector<Entry> firing;
+        size_t now_ms;
+        size_t pending;
+
+        static size_t lowest_bit(uint64_t bits)
+        {
+#if defined(__GNUC__)
+            return static_cast<size_t>(__builtin_ctzll(bits));
+#else
+            size_t bit = 0;
+            while (0 == (bits & 1u))
+            {
+                bits >>= 1;
+                bit++;
+            }
+            return bit;
+#endif
+        }
+
+        void insert(const Entry& entry)
+        {
+            if (entry.deadline_ms <= now_ms)
+            {
+                due.push_back(entry);
+                return;
+            }
+            // the level is the first one whose span holds both the deadline and the current time.
+            for (size_t level = 0; level < levels; level++)
+            {
+                const size_t shift = slot_bits * (level + 1);
+                if ((entry.deadline_ms >> shift) == (now_ms >> shift))
+                {
+                    const size_t slot = (entry.deadline_ms >> (slot_bits * level)) & (slots - 1);
+                    wheel[level][slot].push_back(entry);
+                    occupied[level] |= uint64_t(1) << slot;
+                    return;
+                }
+            }
+            overflow.push_back(entry);
+        }
+
+        void reinsert(std::vector<Entry>& entries)
+        {
+            std::swap(firing, entries);
+            for (const auto& entry : firing)
+            {
+                insert(entry);
+            }
+            firing.clear();
+        }
+
+        void fire(std::vector<Entry>& entries)
+        {
+            std::swap(firing, entries);
+            pending -= firing.size();
+            // a client woken first may cancel the entries of another one, which leaves them without a client.
+            for (size_t i = 0; i < firing.size(); i++)
+            {
+                if (nullptr != firing[i].client)
+                {
+                    firing[i].client->on_timer(firing[i].timer);
+                }
+            }
+            firing.clear();
+        }
+
+        bool remove(std::vector<Entry>& entries, const TimerClient* client, size_t timer, size_t deadline_ms)
+        {
+            for (size_t i = 0; i < entries.size(); i++)
+            {
+                if ((client == entries[i].client) && (timer == entries[i].timer) &&
+                    (deadline_ms == entries[i].deadline_ms))
+                {
+                    entries[i] = entries.back();
+                    entries.pop_back();
+                    pending--;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        ///\brief Time of the next slot that has to be cascaded or fired, or the next overflow check.
+        size_t next_event_ms() const
+        {
+            for (size_t level = 0; level < levels; level++)
+            {
+                if (0 != occupied[level])
+                {
+                    const size_t span = slot_bits * (level + 1);
+                    return ((now_ms >> span) << span) | (lowest_bit(occupied[level]) << (slot_bits * level));
+                }
+            }
+            const size_t span = slot_bits * levels;
+            return overflow.empty() ? SIZE_MAX : (((now_ms >> span) + 1) << span);
+        }
+
+    public:
+        TimerService() : wheel(), overflow(), due(), firing(), now_ms(), pending() {}
+
+        ///\brief Time reached by the last advance().
+        size_t now() const
+        {
+            return now_ms;
+        }
+
+        ///\brief Number of scheduled entries, including the ones of timers stopped since.
+        size_t size() const
+        {
+            return pending;
+        }
+
+        ///\brief Wakes the client at deadline_ms, or on the next advance() if the deadline has passed.
+        void schedule(TimerClient* client, size_t timer, size_t deadline_ms)
+        {
+            pending++;
+            insert(Entry { client, timer, deadline_ms });
+        }
+
+        ///\brief Removes the entry scheduled for the timer at deadline_ms, returns false if it is not pending.
+        bool cancel(const TimerClient* client, size_t timer, size_t deadline_ms)
+        {
+            // an entry only ever sits in the slot its deadline selects on its level, so one slot per level is searched.
+            for (size_t level = 0; level < levels; level++)
+            {
+                const size_t slot = (deadline_ms >> (slot_bits * level)) & (slots - 1);
+                if (remove(wheel[level][slot], client, timer, deadline_ms))
+                {
+                    if (wheel[level][slot].empty())
+                    {
+                        occupied[level] &= ~(uint64_t(1) << slot);
+                    }
+                    return true;
+                }
+            }
+            if (remove(overflow, client, timer, deadline_ms) || remove(due, client, timer, deadline_ms))
+            {
+                return true;
+            }
+            for (auto& entry : firing)
+            {
+                if ((client == entry.client) && (timer == entry.timer) && (deadline_ms == entry.deadline_ms))
+                {
+                    entry.client = nullptr;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        ///\brief Moves the time forward, waking each client at the deadlines it scheduled up to now.
+        void advance(size_t time_ms)
+        {
+            fire(due);
+            while (now_ms < time_ms)
+            {
+                const size_t next_ms = next_event_ms();
+                if (next_ms > time_ms)
+                {
+                    now_ms = time_ms;
+                    break;
+                }
+                now_ms = next_ms;
+
+                // move the entries of the slots starting now one level down, the highest level first.
+                const size_t span = slot_bits * levels;
+                if ((0 == (now_ms & ((size_t(1) << span) - 1))) && !overflow.empty())
+                {
+                    reinsert(overflow);
+                }
+                for (size_t level = levels - 1; level > 0; level--)
+                {
+                    const size_t slot = (now_ms >> (slot_bits * level)) & (slots - 1);
+                    const bool is_start = (0 == (now_ms & ((size_t(1) << (slot_bits * level)) - 1)));
+                    if (is_start && (0 != (occupied[level] & (uint64_t(1) << slot))))
+                    {
+                        occupied[level] &= ~(uint64_t(1) << slot);
+                        reinsert(wheel[level][slot]);
+                    }
+                }
+                const size_t slot = now_ms & (slots - 1);
+                if (0 != (occupied[0] & (uint64_t(1) << slot)))
+                {
+                    occupied[0] &= ~(uint64_t(1) << slot);
+                    due.insert(due.end(), wheel[0][slot].begin(), wheel[0][slot].end());
+                    wheel[0][slot].clear();
+                }
+                fire(due);
+            }
+        }
+    };
+
+)";
+}
+
+void Runtime::write_queues(std::ofstream& out)
+{
+    out << R"(    ///\brief Queue of pending events.
+    template<typename T>
+    using EventQueue = std::deque<T>;
+
+    ///\brief Queue of pending events with a fixed capacity, stored inline so that it never allocates.
+    template<typename T, size_t N>
+    class EventRing
+    {
+    private:
+        T items[N] {};
+        size_t head {};
+        size_t count {};
+
+    public:
+        bool empty() const
+        {
+            return 0 == count;
+        }
+
+        bool full() const
+        {
+            return N == count;
+        }
+
+        size_t size() const
+        {
+            return count;
+        }
+
+        T& front()
+        {
+            return items[head];
+        }
+
+        ///\brief Appends the item, returns false and drops it if the queue is full.
+        bool push_back(const T& item)
+        {
+            if (full())
+            {
+                return false;
+            }
+            items[(head + count) % N] = item;
+            count++;
+            return true;
+        }
+
+        void pop_front()
+        {
+            head = (head + 1) % N;
+            count--;
+        }
+    };
+
+    ///\brief Lock-free queue of in events raised from any thread, drained by its owner.
+    template<typename T, size_t N>
+    class EventIngress
+    {
+    private:
+        static_assert(0 == (N & (N - 1)), "the capacity must be a power of two");
+        struct Cell
+        {
+            std::atomic<size_t> sequence;
+            T item;
+        };
+        Cell cells[N];
+        alignas(64) std::atomic<size_t> tail;
+        alignas(64) size_t head;
+
+    public:
+        EventIngress() : cells(), tail(), head()
+        {
+            for (size_t i = 0; i < N; i++)
+            {
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        ///\brief Appends the item, safe from any thread, returns false if the queue is full.
+        bool push(const T& item)
+        {
+            size_t pos = tail.load(std::memory_order_relaxed);
+            while (true)
+            {
+                Cell& cell = cells[pos & (N - 1)];
+                const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                if (sequence == pos)
+                {
+                    if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        cell.item = item;
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (sequence < pos)
+                {
+                    // the consumer has not freed the cell yet.
+                    return false;
+                }
+                else
+                {
+                    pos = tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        ///\brief Takes the oldest item, only called by the owning thread.
+        bool pop(T& item)
+        {
+            Cell& cell = cells[head & (N - 1)];
+            if (cell.sequence.load(std::memory_order_acquire) != (head + 1))
+            {
+                return false;
+            }
+            item = cell.item;
+            cell.sequence.store(head + N, std::memory_order_release);
+            head++;
+            return true;
+        }
+    };
+
+)";
+}
+
+void Runtime::write_tracing(std::ofstream& out)
+{
+    out << R"(    ///\brief Callback invoked with the state entered or exited.
+    template<typename State>
+    using TraceCallback = std::function<void(State state)>;
+
+)";
+}
+
+void Runtime::write_trace_ring(std::ofstream& out)
+{
+    out << R"(    ///\brief What a trace record describes, its id indexes the matching list of the symbol map.
+    enum class TraceKind : uint16_t
+    {
+        state_enter,
+        state_exit,
+        event_dispatched,
+        guard_passed,
+        guard_failed,
+        transition_taken,
+        timer_expired,
+    };
+
+    ///\brief A decoded trace record, stored in the ring and in dumps as a timestamp and one packed word.
+    struct TraceRecord
+    {
+        uint64_t time_ns;
+        uint16_t model;
+        uint16_t instance;
+        TraceKind kind;
+        uint16_t id;
+    };
+
+    ///\brief Header of a trace dump, followed by count records of two 64 bit words each.
+    struct TraceFileHeader
+    {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t record_size;
+        uint64_t count;
+    };
+
+    constexpr uint64_t trace_file_magic = 0x45434152544e4c50ull;
+    constexpr uint32_t trace_file_version = 1;
+
+    ///\brief Preallocated ring of fixed size trace records, written lock-free from any thread.
+    ///
+    /// Once full, the oldest records are overwritten, so the ring always holds the latest history for a post-mortem
+    /// dump. Each slot carries the position it was written for, readers skip slots that are being rewritten.
+    class TraceRing
+    {
+    private:
+        struct Slot
+        {
+            std::atomic<uint64_t> sequence;
+            std::atomic<uint64_t> time_ns;
+            std::atomic<uint64_t> data;
+        };
+        std::unique_ptr<Slot[]> slots;
+        size_t mask;
+        alignas(64) std::atomic<uint64_t> head;
+
+        static uint64_t now_ns()
+        {
+            const auto now = std::chrono::steady_clock::now().time_since_epoch();
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+        }
+
+        ///\brief Reads the record written at pos, returns false if it was overwritten or is being written.
+        bool read(uint64_t pos, uint64_t& time_ns, uint64_t& data) const
+        {
+            const Slot& slot = slots[pos & mask];
+            if (slot.sequence.load(std::memory_order_acquire) != (pos + 1))
+            {
+                return false;
+            }
+            time_ns = slot.time_ns.load(std::memory_order_relaxed);
+            data = slot.data.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return slot.sequence.load(std::memory_order_relaxed) == (pos + 1);
+        }
+
+    public:
+        ///\brief Allocates all slots up front, the capacity is rounded up to a power of two.
+        explicit TraceRing(size_t capacity) : slots(), mask(), head()
+        {
+            size_t size = 1;
+            while (size < capacity)
+            {
+                size <<= 1;
+            }
+            slots.reset(new Slot[size]);
+            mask = size - 1;
+            for (size_t i = 0; i < size; i++)
+            {
+                slots[i].sequence.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        size_t capacity() const
+        {
+            return mask + 1;
+        }
+
+        ///\brief Number of records written since the ring was created, including the overwritten ones.
+        uint64_t written() const
+        {
+            return head.load(std::memory_order_relaxed);
+        }
+
+        ///\brief Appends a record stamped with the current time, safe from any thread and never blocks.
+        void record(uint16_t model, uint16_t instance, TraceKind kind, uint16_t id)
+        {
+            const uint64_t time_ns = now_ns();
+            const uint64_t pos = head.fetch_add(1, std::memory_order_relaxed);
+            Slot& slot = slots[pos & mask];
+            slot.sequence.store(0, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            slot.time_ns.store(time_ns, std::memory_order_relaxed);
+            slot.data.store((uint64_t(model) << 48) | (uint64_t(instance) << 32) |
+                    (uint64_t(static_cast<uint16_t>(kind)) << 16) | uint64_t(id),
+                std::memory_order_relaxed);
+            slot.sequence.store(pos + 1, std::memory_order_release);
+        }
+
+        ///\brief Copies up to count of the latest records, oldest first, returns the number copied.
+        size_t snapshot(TraceRecord* records, size_t count) const
+        {
+            const uint64_t end = head.load(std::memory_order_acquire);
+            const uint64_t span = (end < capacity()) ? end : capacity();
+            size_t copied = 0;
+            for (uint64_t pos = end - ((span < count) ? span : count); pos < end; pos++)
+            {
+                uint64_t time_ns = 0;
+                uint64_t data = 0;
+                if (read(pos, time_ns, data))
+                {
+                    records[copied].time_ns = time_ns;
+                    records[copied].model = static_cast<uint16_t>(data >> 48);
+                    records[copied].instance = static_cast<uint16_t>(data >> 32);
+                    records[copied].kind = static_cast<TraceKind>(static_cast<uint16_t>(data >> 16));
+                    records[copied].id = static_cast<uint16_t>(data);
+                    copied++;
+                }
+            }
+            return copied;
+        }
+
+        ///\brief Writes the latest records to a file for tracedump without allocating, returns false on failure.
+        bool dump(const char* path) const
+        {
+            std::FILE* file = std::fopen(path, "wb");
+            if (nullptr == file)
+            {
+                return false;
+            }
+            const uint64_t end = head.load(std::memory_order_acquire);
+            const uint64_t begin = end - ((end < capacity()) ? end : capacity());
+            TraceFileHeader header { trace_file_magic, trace_file_version, 2 * sizeof(uint64_t), 0 };
+            bool is_written = (1 == std::fwrite(&header, sizeof(header), 1, file));
+            for (uint64_t pos = begin; is_written && (pos < end); pos++)
+            {
+                uint64_t words[2] {};
+                if (read(pos, words[0], words[1]))
+                {
+                    is_written = (1 == std::fwrite(words, sizeof(words), 1, file));
+                    header.count++;
+                }
+            }
+            // the count is only known once the skipped slots are, so the header is written again.
+            if (is_written && (0 == std::fseek(file, 0, SEEK_SET)))
+            {
+                is_written = (1 == std::fwrite(&header, sizeof(header), 1, file));
+            }
+            return (0 == std::fclose(file)) && is_written;
+        }
+    };
+)";
+}
@@ -89,6 +89,11 @@ std::string Style::get_state_exit(const State* state)
     return "state_" + convert_snake_case(get_state_base_decl(state)) + "_exit_action";
 }
 
+std::string Style::get_state_choice(const State* state)
+{
+    return "state_" + convert_snake_case(get_state_base_decl(state)) + "_choice";
+}
+
 std::string Style::get_state_name(const State* state)
 {
     return get_state_type() + "::" + convert_snake_case(get_state_base_decl(state));
@@ -0,0 +1,338 @@
+/** @file
+ *  @brief Decodes a binary trace dumped from a plantgen::TraceRing into a log or a PlantUML diagram.
+ */
+
+#include "../include/tracemap.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+///\brief Layout of the dump header written by TraceRing::dump().
+struct TraceFileHeader
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t count;
+};
+
+///\brief A record of the dump, unpacked.
+struct TraceEntry
+{
+    uint64_t time_ns;
+    uint16_t model;
+    uint16_t instance;
+    uint16_t kind;
+    uint16_t id;
+};
+
+///\brief Kinds of records, in the order of plantgen::TraceKind.
+enum class TraceKind : uint16_t
+{
+    StateEnter,
+    StateExit,
+    EventDispatched,
+    GuardPassed,
+    GuardFailed,
+    TransitionTaken,
+    TimerExpired,
+};
+
+constexpr uint64_t trace_file_magic   = 0x45434152544e4c50ull;
+constexpr uint32_t trace_file_version = 1;
+
+// the name of each TraceKind, and the list of the symbol map that its ids index.
+const std::vector<std::pair<std::string, std::string>> trace_kinds = {
+    { "enter", "state" },
+    { "exit", "state" },
+    { "event", "event" },
+    { "guard passed", "transition" },
+    { "guard failed", "transition" },
+    { "transition", "transition" },
+    { "timer", "timer" },
+};
+
+void print_usage()
+{
+    std::cout << "tracedump [options]" << std::endl << std::endl;
+    std::cout << "\t-h\t\t\tPrint help information" << std::endl;
+    std::cout << "\t-i <file>\tTrace dumped by TraceRing::dump()" << std::endl;
+    std::cout << "\t-m <file>\tSymbol map <model>.trace.map written by codegen --trace-ring, once per model"
+              << std::endl;
+    std::cout << "\t--format=<f>\t\tWrite a log (log), a PlantUML sequence (sequence) or timing (timing) diagram"
+              << std::endl
+              << std::endl;
+    std::cout << "\tDefault values:" << std::endl;
+    std::cout << "\t\tFormat:           log" << std::endl;
+}
+
+int parse_arguments(
+    int                       argc,
+    char*                     argv[],
+    std::string&              in,
+    std::vector<std::string>& maps,
+    std::string&              format)
+{
+    for (auto i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if ("-h" == arg)
+        {
+            return 1;
+        }
+        else if ((("-i" == arg) || ("-m" == arg)) && (argc <= (i + 1)))
+        {
+            std::cerr << arg << " requires <file>" << std::endl;
+            return 1;
+        }
+        else if ("-i" == arg)
+        {
+            in = argv[++i];
+        }
+        else if ("-m" == arg)
+        {
+            maps.emplace_back(argv[++i]);
+        }
+        else if (("--format=log" == arg) || ("--format=sequence" == arg) || ("--format=timing" == arg))
+        {
+            format = arg.substr(9);
+        }
+        else
+        {
+            std::cout << "Unknown parameter given: " << arg << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+bool read_trace(const std::string& path, std::vector<TraceEntry>& entries)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open())
+    {
+        std::cout << "ERR: Failed to open " << path << std::endl;
+        return false;
+    }
+
+    TraceFileHeader header {};
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || (trace_file_magic != header.magic)
+        || (trace_file_version != header.version) || ((2 * sizeof(uint64_t)) != header.record_size))
+    {
+        std::cout << "ERR: " << path << " is not a trace dump of this version" << std::endl;
+        return false;
+    }
+    for (uint64_t i = 0; i < header.count; i++)
+    {
+        uint64_t words[2] {};
+        if (!in.read(reinterpret_cast<char*>(words), sizeof(words)))
+        {
+            std::cout << "ERR: " << path << " ends after " << i << " of " << header.count << " records" << std::endl;
+            return false;
+        }
+        TraceEntry entry {};
+        entry.time_ns  = words[0];
+        entry.model    = static_cast<uint16_t>(words[1] >> 48);
+        entry.instance = static_cast<uint16_t>(words[1] >> 32);
+        entry.kind     = static_cast<uint16_t>(words[1] >> 16);
+        entry.id       = static_cast<uint16_t>(words[1]);
+        entries.push_back(entry);
+    }
+    return true;
+}
+
+std::string get_machine_name(const std::map<uint16_t, TraceMap>& maps, const TraceEntry& entry)
+{
+    auto found = maps.find(entry.model);
+    const auto model = (maps.end() == found) ? ("model" + std::to_string(entry.model)) : found->second.get_model();
+    return model + "#" + std::to_string(entry.instance);
+}
+
+std::string get_entry_name(const std::map<uint16_t, TraceMap>& maps, const TraceEntry& entry)
+{
+    if (trace_kinds.size() <= entry.kind)
+    {
+        return std::to_string(entry.id);
+    }
+    auto found = maps.find(entry.model);
+    if (maps.end() == found)
+    {
+        return std::to_string(entry.id);
+    }
+    return found->second.get_name(trace_kinds[entry.kind].second, entry.id);
+}
+
+std::string get_kind_name(const TraceEntry& entry)
+{
+    return (trace_kinds.size() <= entry.kind) ? ("kind" + std::to_string(entry.kind)) : trace_kinds[entry.kind].first;
+}
+
+void write_log(const std::map<uint16_t, TraceMap>& maps, const std::vector<TraceEntry>& entries)
+{
+    const uint64_t start_ns = entries.empty() ? 0 : entries.front().time_ns;
+    for (const auto& entry : entries)
+    {
+        // microseconds since the oldest record, which is as far back as the ring reached.
+        const uint64_t delta_ns = (entry.time_ns > start_ns) ? (entry.time_ns - start_ns) : 0;
+        std::cout << std::setw(14) << std::fixed << std::setprecision(3) << (static_cast<double>(delta_ns) / 1000.0)
+                  << " us  " << get_machine_name(maps, entry) << "  " << get_kind_name(entry) << "  "
+                  << get_entry_name(maps, entry) << std::endl;
+    }
+}
+
+std::map<std::string, std::string> get_participants(
+    const std::map<uint16_t, TraceMap>& maps,
+    const std::vector<TraceEntry>&      entries)
+{
+    std::map<std::string, std::string> participants {};
+    for (const auto& entry : entries)
+    {
+        const auto name = get_machine_name(maps, entry);
+        if (participants.end() == participants.find(name))
+        {
+            const auto alias = "m" + std::to_string(participants.size());
+            participants[name] = alias;
+        }
+    }
+    return participants;
+}
+
+void write_sequence(const std::map<uint16_t, TraceMap>& maps, const std::vector<TraceEntry>& entries)
+{
+    const auto participants = get_participants(maps, entries);
+
+    std::cout << "@startuml" << std::endl;
+    for (const auto& participant : participants)
+    {
+        std::cout << "participant \"" << participant.first << "\" as " << participant.second << std::endl;
+    }
+    for (const auto& entry : entries)
+    {
+        const auto alias = participants.at(get_machine_name(maps, entry));
+        const auto name  = get_entry_name(maps, entry);
+        switch (static_cast<TraceKind>(entry.kind))
+        {
+            case TraceKind::StateEnter:
+                std::cout << "hnote over " << alias << " : " << name << std::endl;
+                break;
+
+            case TraceKind::EventDispatched:
+                std::cout << "[-> " << alias << " : " << name << std::endl;
+                break;
+
+            case TraceKind::GuardPassed:
+            case TraceKind::GuardFailed:
+                std::cout << "note right of " << alias << " : " << get_kind_name(entry) << " on " << name
+                          << std::endl;
+                break;
+
+            case TraceKind::TransitionTaken:
+                std::cout << alias << " -> " << alias << " : " << name << std::endl;
+                break;
+
+            case TraceKind::TimerExpired:
+                std::cout << "[o-> " << alias << " : timer " << name << std::endl;
+                break;
+
+            default:
+                // exits are implied by the next entry.
+                break;
+        }
+    }
+    std::cout << "@enduml" << std::endl;
+}
+
+void write_timing(const std::map<uint16_t, TraceMap>& maps, const std::vector<TraceEntry>& entries)
+{
+    const auto participants = get_participants(maps, entries);
+
+    // the time axis is in microseconds, a state entered and left within one of them is not drawn.
+    std::vector<std::pair<uint64_t, std::map<std::string, std::string>>> changes {};
+    const uint64_t start_ns = entries.empty() ? 0 : entries.front().time_ns;
+    uint64_t       last_us  = 0;
+    for (const auto& entry : entries)
+    {
+        if (TraceKind::StateEnter != static_cast<TraceKind>(entry.kind))
+        {
+            continue;
+        }
+        const uint64_t delta_ns = (entry.time_ns > start_ns) ? (entry.time_ns - start_ns) : 0;
+        last_us                 = std::max(last_us, delta_ns / 1000);
+        if (changes.empty() || (changes.back().first != last_us))
+        {
+            changes.emplace_back(last_us, std::map<std::string, std::string> {});
+        }
+        changes.back().second[participants.at(get_machine_name(maps, entry))] = get_entry_name(maps, entry);
+    }
+
+    std::cout << "@startuml" << std::endl;
+    for (const auto& participant : participants)
+    {
+        std::cout << "robust \"" << participant.first << "\" as " << participant.second << std::endl;
+    }
+    for (const auto& change : changes)
+    {
+        std::cout << std::endl << "@" << change.first << std::endl;
+        for (const auto& state : change.second)
+        {
+            std::cout << state.first << " is \"" << state.second << "\"" << std::endl;
+        }
+    }
+    std::cout << "@enduml" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string              in {};
+    std::vector<std::string> map_files {};
+    std::string              format = "log";
+
+    if (0 != parse_arguments(argc, argv, in, map_files, format))
+    {
+        print_usage();
+        return 1;
+    }
+    else if (in.empty())
+    {
+        print_usage();
+        return 1;
+    }
+
+    std::map<uint16_t, TraceMap> maps {};
+    for (const auto& file : map_files)
+    {
+        TraceMap map {};
+        if (!map.load(file))
+        {
+            std::cout << "ERR: Failed to read the symbol map " << file << std::endl;
+            return 1;
+        }
+        maps[TraceMap::get_model_id(map.get_model())] = map;
+    }
+
+    std::vector<TraceEntry> entries {};
+    if (!read_trace(in, entries))
+    {
+        return 1;
+    }
+
+    if ("sequence" == format)
+    {
+        write_sequence(maps, entries);
+    }
+    else if ("timing" == format)
+    {
+        write_timing(maps, entries);
+    }
+    else
+    {
+        write_log(maps, entries);
+    }
+    return 0;
+}
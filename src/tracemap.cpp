@@ -0,0 +1,102 @@
+/** @file
+ *  @brief Implementation of the trace symbol map.
+ */
+
+#include "../include/tracemap.hpp"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+TraceMap::TraceMap() : model(), names() {}
+
+uint16_t TraceMap::get_model_id(const std::string& model)
+{
+    uint32_t hash = 2166136261u;
+    for (auto c : model)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return static_cast<uint16_t>((hash >> 16) ^ (hash & 0xffffu));
+}
+
+void TraceMap::set_model(const std::string& name)
+{
+    model = name;
+}
+
+const std::string& TraceMap::get_model() const
+{
+    return model;
+}
+
+void TraceMap::add(const std::string& kind, const std::string& name)
+{
+    names[kind].push_back(name);
+}
+
+std::string TraceMap::get_name(const std::string& kind, size_t id) const
+{
+    auto found = names.find(kind);
+    if ((names.end() == found) || (found->second.size() <= id))
+    {
+        return std::to_string(id);
+    }
+    return found->second[id];
+}
+
+bool TraceMap::generate(const std::string& path) const
+{
+    std::ofstream out {};
+    out.open(path);
+    if (!out.is_open())
+    {
+        std::cout << "ERR: Failed to open " << path << std::endl;
+        return false;
+    }
+
+    // each line is "<kind> <name>", the ids count up from 0 in the order of the lines of each kind.
+    out << "model " << model << std::endl;
+    for (const auto& kind : names)
+    {
+        for (const auto& name : kind.second)
+        {
+            out << kind.first << " " << name << std::endl;
+        }
+    }
+    out.close();
+    return true;
+}
+
+bool TraceMap::load(const std::string& path)
+{
+    std::ifstream in(path);
+    if (!in.is_open())
+    {
+        return false;
+    }
+
+    std::string line {};
+    while (std::getline(in, line))
+    {
+        std::istringstream iss(line);
+        std::string        kind {};
+        if (!(iss >> kind))
+        {
+            continue;
+        }
+
+        std::string name {};
+        std::getline(iss >> std::ws, name);
+        if ("model" == kind)
+        {
+            model = name;
+        }
+        else
+        {
+            add(kind, name);
+        }
+    }
+    return !model.empty();
+}
@@ -3,13 +3,31 @@
  */
 
 #include "../include/writer.hpp"
+#include "../include/analyzer.hpp"
+#include "../include/footprint.hpp"
 #include "../include/reader.hpp"
+#include "../include/runtime.hpp"
+#include "../include/tracemap.hpp"
+#include <algorithm>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 
 Writer::Writer(const std::string& filename, const std::string& outdir, const WriterConfig& cfg) :
-    config(cfg), filename(filename), outdir(outdir), reader(filename, cfg.verbose), styler(reader), indent()
+    config(cfg),
+    filename(filename),
+    outdir(outdir),
+    reader(filename, cfg.verbose),
+    styler(reader),
+    indent(),
+    entry_functions(),
+    exit_functions(),
+    react_functions(),
+    profile(),
+    queue_capacity(),
+    queue_overflow(QueueOverflow::Assert),
+    tables()
 {
 }
 
@@ -17,6 +35,45 @@ void Writer::generateCode()
 {
     styler.set_simple_names(config.use_simple_names);
 
+    auto backend = config.flatten_dispatch ? DispatchBackend::Flat : DispatchBackend::Recursive;
+    if (config.table_backend)
+    {
+        backend = DispatchBackend::Table;
+    }
+    Analyzer analyzer(reader, is_parent_first(), backend);
+    analyzer.analyze();
+    analyzer.report();
+    if (config.strip_dead_code)
+    {
+        analyzer.eliminate_dead_code();
+    }
+    if (config.minimize)
+    {
+        analyzer.minimize();
+    }
+    if (config.wcet_report)
+    {
+        analyzer.report_wcet();
+    }
+    if (!config.profile.empty() && !profile.load(config.profile))
+    {
+        error_report("Failed to read the profile " + config.profile, __LINE__);
+    }
+
+    // the command line overrides the queue set in the diagram header.
+    queue_capacity = (0 < config.queue_capacity) ? config.queue_capacity : reader.get_queue_capacity();
+    queue_overflow = reader.get_queue_overflow();
+    if (!config.queue_overflow.empty() && !Reader::parse_queue_overflow(config.queue_overflow, queue_overflow))
+    {
+        error_report("Unknown queue overflow policy " + config.queue_overflow, __LINE__);
+    }
+
+    find_shared_functions();
+    if (config.table_backend)
+    {
+        build_dispatch_tables();
+    }
+
     auto model = reader.get_model_name();
     if (!model.empty())
     {
@@ -44,22 +101,71 @@ void Writer::generateCode()
         return;
     }
 
+    if (config.shared_runtime && !Runtime::generate(outdir))
+    {
+        error_report("Failed to write the runtime header.", __LINE__);
+        return;
+    }
+
+    // the lean header only needs the runtime when the tracing types are exposed.
+    const bool header_uses_runtime =
+            config.shared_runtime && (!config.lean_header || uses_trace_hook(TraceHook::Function) || config.trace_ring);
+
     out_h << "/** @file" << std::endl;
     out_h << " *  @brief Interface to the " << reader.get_model_name() << " state machine." << std::endl;
-    out_h << " *" << std::endl;
-    out_h << " *  @startuml" << std::endl;
-    for (size_t i = 0; i < reader.get_uml_line_count(); i++)
+    if (!config.lean_header)
     {
-        out_h << " *  " << reader.get_uml_line(i) << std::endl;
+        // the lean header leaves out the diagram, so that editing it does not touch the header.
+        out_h << " *" << std::endl;
+        out_h << " *  @startuml" << std::endl;
+        for (size_t i = 0; i < reader.get_uml_line_count(); i++)
+        {
+            out_h << " *  " << reader.get_uml_line(i) << std::endl;
+        }
+        out_h << " *  @enduml" << std::endl;
     }
-    out_h << " *  @enduml" << std::endl;
     out_h << " */" << std::endl << std::endl;
 
     out_h << get_indent() << "#include <cstdint>" << std::endl;
     out_h << get_indent() << "#include <cstddef>" << std::endl;
-    out_h << get_indent() << "#include <functional>" << std::endl;
-    out_h << get_indent() << "#include <deque>" << std::endl;
-    out_h << get_indent() << "#include <string>" << std::endl;
+    if (!config.lean_header)
+    {
+        if (0 < config.ingress_capacity)
+        {
+            out_h << get_indent() << "#include <atomic>" << std::endl;
+        }
+        if (config.deferred_dispatch)
+        {
+            out_h << get_indent() << "#include <chrono>" << std::endl;
+        }
+        out_h << get_indent() << "#include <functional>" << std::endl;
+        if ((0 == queue_capacity) || config.fleet)
+        {
+            out_h << get_indent() << "#include <deque>" << std::endl;
+        }
+        out_h << get_indent() << "#include <string>" << std::endl;
+        if (config.fleet)
+        {
+            out_h << get_indent() << "#include <utility>" << std::endl;
+            out_h << get_indent() << "#include <vector>" << std::endl;
+        }
+    }
+    else
+    {
+        // the tracing callbacks, state names, the profile and the process deadline are part of the public API.
+        if (config.deferred_dispatch)
+        {
+            out_h << get_indent() << "#include <chrono>" << std::endl;
+        }
+        if (uses_trace_hook(TraceHook::Function))
+        {
+            out_h << get_indent() << "#include <functional>" << std::endl;
+        }
+        if (config.do_tracing || config.instrument)
+        {
+            out_h << get_indent() << "#include <string>" << std::endl;
+        }
+    }
 
     for (auto i = 0u; i < reader.getImportCount(); i++)
     {
@@ -76,6 +182,11 @@ void Writer::generateCode()
     }
     out_h << std::endl;
 
+    if (header_uses_runtime)
+    {
+        write_runtime_include(out_h);
+    }
+
     // setup namespace
     start_namespace(out_h);
 
@@ -85,14 +196,30 @@ void Writer::generateCode()
     // write all event types
     decl_event_list(out_h);
 
-    // write all variables
-    decl_variable_list(out_h);
+    if (!config.lean_header)
+    {
+        // write the fixed capacity queue and all time event types
+        decl_event_ring(out_h);
+        decl_event_ingress(out_h);
+        decl_time_event_list(out_h);
+
+        // write all variables
+        decl_variable_list(out_h);
+    }
 
     // write tracing callback types
     decl_tracing_callback(out_h);
 
     // write main declaration
-    decl_state_machine(out_h);
+    if (config.lean_header)
+    {
+        decl_lean_interface(out_h);
+    }
+    else
+    {
+        decl_state_machine(out_h);
+        decl_fleet(out_h);
+    }
 
     // end namespace
     end_namespace(out_h);
@@ -100,6 +227,44 @@ void Writer::generateCode()
     // write header to .c
     out_c << get_indent() << "#include \"" << model << ".h\"" << std::endl << std::endl;
 
+    if ((config.tickless_timers && (0 < reader.getTimeEventCount())) || config.fleet)
+    {
+        out_c << get_indent() << "#include <algorithm>" << std::endl;
+    }
+    if (config.fleet && (is_fleet_simd() || (0 < reader.getTimeEventCount())))
+    {
+        out_c << "#if defined(__AVX2__) || defined(__SSSE3__)" << std::endl;
+        out_c << get_indent() << "#include <immintrin.h>" << std::endl;
+        out_c << "#endif" << std::endl;
+    }
+    if (config.fleet_snapshot)
+    {
+        out_c << get_indent() << "#include <cstring>" << std::endl;
+        out_c << get_indent() << "#include <fstream>" << std::endl;
+        out_c << get_indent() << "#include <type_traits>" << std::endl;
+        out_c << get_indent() << "#include <fcntl.h>" << std::endl;
+        out_c << get_indent() << "#include <sys/mman.h>" << std::endl;
+        out_c << get_indent() << "#include <sys/stat.h>" << std::endl;
+        out_c << get_indent() << "#include <unistd.h>" << std::endl;
+    }
+    if (config.lean_header)
+    {
+        if (0 < config.ingress_capacity)
+        {
+            out_c << get_indent() << "#include <atomic>" << std::endl;
+        }
+        if (0 == queue_capacity)
+        {
+            out_c << get_indent() << "#include <deque>" << std::endl;
+        }
+        out_c << get_indent() << "#include <functional>" << std::endl;
+        out_c << get_indent() << "#include <string>" << std::endl;
+    }
+    if ((0 < queue_capacity) && (QueueOverflow::Assert == queue_overflow))
+    {
+        out_c << get_indent() << "#include <cassert>" << std::endl;
+    }
+
     for (auto i = 0u; i < reader.getImportCount(); i++)
     {
         auto imp = reader.getImport(i);
@@ -113,11 +278,39 @@ void Writer::generateCode()
             out_c << "\"" << imp->name << "\"" << std::endl;
         }
     }
+    if (uses_trace_hook(TraceHook::Static))
+    {
+        // the tracer may also come from an import of the diagram, or from a forced include.
+        out_c << "#if defined(PLANTGEN_TRACER_HEADER)" << std::endl;
+        out_c << get_indent() << "#include PLANTGEN_TRACER_HEADER" << std::endl;
+        out_c << "#endif" << std::endl;
+    }
     out_c << std::endl;
 
+    if (config.shared_runtime && !header_uses_runtime)
+    {
+        write_runtime_include(out_c);
+    }
+
+    if (profile.has_data())
+    {
+        write_profile_macros(out_c);
+    }
+
     // setup namespace
     start_namespace(out_c);
 
+    if (config.lean_header)
+    {
+        // the private parts are only visible to the implementation.
+        decl_event_ring(out_c);
+        decl_event_ingress(out_c);
+        decl_time_event_list(out_c);
+        decl_variable_list(out_c);
+        decl_state_machine(out_c);
+        impl_lean_interface(out_c);
+    }
+
     // find first state on init
     const auto firstState = find_init_state();
 
@@ -129,15 +322,33 @@ void Writer::generateCode()
 
     // write all raise event functions
     impl_raise_in_event(out_c);
+    impl_drain(out_c);
+    impl_process(out_c);
     impl_check_out_event(out_c);
     impl_get_variable(out_c);
+    if (config.instrument)
+    {
+        impl_profile(out_c);
+    }
     impl_time_tick(out_c);
-    impl_top_run_cycle(out_c);
-    impl_run_cycle(out_c);
+    impl_next_timeout(out_c);
+    impl_on_timer(out_c);
+    if (config.table_backend)
+    {
+        decl_dispatch_tables(out_c);
+        impl_table_run_cycle(out_c);
+        impl_table_functions(out_c);
+    }
+    else
+    {
+        impl_top_run_cycle(out_c);
+        impl_run_cycle(out_c);
+    }
     impl_entry_action(out_c);
     impl_exit_action(out_c);
     impl_raise_out_event(out_c);
     impl_raise_internal_event(out_c);
+    impl_fleet(out_c);
 
     // end namespace
     end_namespace(out_c);
@@ -145,6 +356,36 @@ void Writer::generateCode()
     // close streams
     out_c.close();
     out_h.close();
+
+    if (config.footprint)
+    {
+        Footprint footprint(reader, config, queue_capacity);
+        for (auto i = 0u; i < reader.getStateCount(); i++)
+        {
+            auto state = reader.getState(i);
+            auto body  = react_functions.bodies.find(state->id);
+            if (react_functions.bodies.end() != body)
+            {
+                std::vector<std::string> states {};
+                for (const auto& owner : react_functions.owners)
+                {
+                    if (state->id == owner.second)
+                    {
+                        states.push_back(reader.getStateById(owner.first)->name);
+                    }
+                }
+                footprint.add_function(styler.get_state_run_cycle(state), states, body->second);
+            }
+        }
+        if (!footprint.generate(outdir + model + ".footprint.json"))
+        {
+            error_report("Failed to write the footprint report.", __LINE__);
+        }
+    }
+    if (config.trace_ring && !generate_trace_map(outdir + model + ".trace.map"))
+    {
+        error_report("Failed to write the trace map.", __LINE__);
+    }
 }
 
 void Writer::error_report(const std::string& str, unsigned int line)
@@ -172,7 +413,7 @@ void Writer::reset_indent()
     indent = 0;
 }
 
-void Writer::start_namespace(std::ofstream& out)
+void Writer::start_namespace(std::ostream& out)
 {
     reset_indent();
     out << "namespace " << reader.get_model_name() << std::endl;
@@ -180,15 +421,16 @@ void Writer::start_namespace(std::ofstream& out)
     increase_indent();
 }
 
-void Writer::end_namespace(std::ofstream& out)
+void Writer::end_namespace(std::ostream& out)
 {
     reset_indent();
     out << "}" << std::endl << std::endl;
 }
 
-void Writer::decl_state_list(std::ofstream& out)
+void Writer::decl_state_list(std::ostream& out)
 {
-    out << get_indent() << "enum class " << Style::get_state_type() << std::endl;
+    out << get_indent() << "enum class " << Style::get_state_type() << get_enum_base(get_enum_states().size())
+        << std::endl;
     out << get_indent() << "{" << std::endl;
     increase_indent();
 
@@ -209,7 +451,7 @@ void Writer::decl_state_list(std::ofstream& out)
     out << get_indent() << "};" << std::endl << std::endl;
 }
 
-void Writer::decl_event_list(std::ofstream& out)
+void Writer::decl_event_list(std::ostream& out)
 {
     const auto n_in_events       = reader.getInEventCount();
     const auto n_out_events      = reader.getOutEventCount();
@@ -219,7 +461,8 @@ void Writer::decl_event_list(std::ofstream& out)
     // create an enum of all out-event names, out-events are on a separate queue since these are cleared by the user.
     if (0 < n_out_events)
     {
-        out << get_indent() << "enum class " << reader.get_model_name() << "_OutEventId" << std::endl;
+        out << get_indent() << "enum class " << reader.get_model_name() << "_OutEventId" << get_enum_base(n_out_events)
+            << std::endl;
         out << get_indent() << "{" << std::endl;
         increase_indent();
 
@@ -280,41 +523,11 @@ void Writer::decl_event_list(std::ofstream& out)
         out << get_indent() << "};" << std::endl << std::endl;
     }
 
-    if (0 < n_time_events)
-    {
-        out << get_indent() << "struct TimeEvent" << std::endl;
-        out << get_indent() << "{" << std::endl;
-        increase_indent();
-
-        out << get_indent() << "bool is_started {};" << std::endl;
-        out << get_indent() << "bool is_periodic {};" << std::endl;
-        out << get_indent() << "size_t timeout_ms {};" << std::endl;
-        out << get_indent() << "size_t expire_time_ms {};" << std::endl;
-        decrease_indent();
-
-        out << get_indent() << "};" << std::endl << std::endl;
-
-        out << get_indent() << "struct TimeEvents" << std::endl;
-        out << get_indent() << "{" << std::endl;
-        increase_indent();
-
-        for (auto i = 0u; i < n_time_events; i++)
-        {
-            auto ev = reader.getTimeEvent(i);
-            if ((nullptr != ev) && ("null" != ev->name))
-            {
-                out << get_indent() << "TimeEvent " << Style::get_event_name(ev) << " {};" << std::endl;
-            }
-        }
-        decrease_indent();
-
-        out << get_indent() << "};" << std::endl << std::endl;
-    }
-
     // create an enum of all in-event names
     if ((0 < n_in_events) || (0 < n_time_events) || (0 < n_internal_events))
     {
-        out << get_indent() << "enum class EventId" << std::endl;
+        out << get_indent() << "enum class EventId"
+            << get_enum_base(n_in_events + n_time_events + n_internal_events) << std::endl;
         out << get_indent() << "{" << std::endl;
         increase_indent();
 
@@ -395,1069 +608,4613 @@ void Writer::decl_event_list(std::ofstream& out)
     }
 }
 
-void Writer::decl_variable_list(std::ofstream& out)
+void Writer::decl_event_ring(std::ostream& out)
 {
-    const auto n_private = reader.getPrivateVariableCount();
-    const auto n_public  = reader.getPublicVariableCount();
-
-    if ((0 == n_private) && (0 == n_public))
+    if ((0 == queue_capacity) || config.shared_runtime)
     {
-        // no variables!
+        return;
     }
-    else
-    {
-        out << get_indent() << "struct Variables" << std::endl;
-        out << get_indent() << "{" << std::endl;
-        increase_indent();
 
-        // write private
-        if (0 < n_private)
-        {
-            out << get_indent() << "struct InternalVariables" << std::endl;
-            out << get_indent() << "{" << std::endl;
-            increase_indent();
+    out << get_indent() << "///\\brief Queue of pending events with a fixed capacity, stored inline." << std::endl;
+    out << get_indent() << "template<typename T, size_t N>" << std::endl;
+    out << get_indent() << "class EventRing" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    out << get_indent() << "private:" << std::endl;
+    increase_indent();
 
-            for (auto i = 0u; i < n_private; i++)
-            {
-                auto var = reader.getPrivateVariable(i);
-                if ((nullptr != var) && (var->is_private))
-                {
-                    out << get_indent() << var->type << " " << Style::get_variable_name(var) << " {};" << std::endl;
-                }
-            }
-            decrease_indent();
+    out << get_indent() << "T items[N] {};" << std::endl;
+    out << get_indent() << "size_t head {};" << std::endl;
+    out << get_indent() << "size_t count {};" << std::endl << std::endl;
+    decrease_indent();
 
-            out << get_indent() << "} internal {};" << std::endl;
-        }
+    out << get_indent() << "public:" << std::endl;
+    increase_indent();
 
-        // write public
-        if (0 < n_public)
-        {
-            out << get_indent() << "struct ExportedVariables" << std::endl;
-            out << get_indent() << "{" << std::endl;
-            increase_indent();
+    out << get_indent() << "bool empty() const { return 0 == count; }" << std::endl;
+    out << get_indent() << "bool full() const { return N == count; }" << std::endl;
+    out << get_indent() << "size_t size() const { return count; }" << std::endl;
+    out << get_indent() << "T& front() { return items[head]; }" << std::endl << std::endl;
 
-            for (size_t i = 0; i < n_public; i++)
-            {
-                auto var = reader.getPublicVariable(i);
-                if ((nullptr != var) && !var->is_private)
-                {
-                    out << get_indent() << var->type << " " << Style::get_variable_name(var) << " {};" << std::endl;
-                }
-            }
-            decrease_indent();
+    out << get_indent() << "///\\brief Appends the item, returns false and drops it if the queue is full." << std::endl;
+    out << get_indent() << "bool push_back(const T& item)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
 
-            out << get_indent() << "} exported {};" << std::endl;
-        }
-        decrease_indent();
+    out << get_indent() << "if (full())" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
 
-        out << get_indent() << "};" << std::endl << std::endl;
-    }
+    out << get_indent() << "return false;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    out << get_indent() << "items[(head + count) % N] = item;" << std::endl;
+    out << get_indent() << "count++;" << std::endl;
+    out << get_indent() << "return true;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+
+    out << get_indent() << "void pop_front()" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "head = (head + 1) % N;" << std::endl;
+    out << get_indent() << "count--;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "};" << std::endl << std::endl;
 }
 
-void Writer::decl_tracing_callback(std::ofstream& out)
+void Writer::decl_event_ingress(std::ostream& out)
 {
-    if (config.do_tracing)
+    if ((0 == config.ingress_capacity) || (0 == reader.getInEventCount()) || config.shared_runtime)
     {
-        out << get_indent() << "using TraceEntry_t = std::function<void(" << Style::get_state_type() << " state)>;"
-            << std::endl;
-        out << get_indent() << "using TraceExit_t = std::function<void(" << Style::get_state_type() << " state)>;"
-            << std::endl
-            << std::endl;
+        return;
     }
-}
 
-void Writer::decl_state_machine(std::ofstream& out)
-{
-    // write internal structure
-    out << "///\\brief State machine base class for " << reader.get_model_name() << "." << std::endl;
-    out << get_indent() << "class " << reader.get_model_name() << std::endl;
+    // bounded multi producer, single consumer queue, each cell carries a sequence number telling whose turn it is.
+    out << get_indent() << "///\\brief Lock-free queue of in events raised from any thread, drained by its owner."
+        << std::endl;
+    out << get_indent() << "template<typename T, size_t N>" << std::endl;
+    out << get_indent() << "class EventIngress" << std::endl;
     out << get_indent() << "{" << std::endl;
     out << get_indent() << "private:" << std::endl;
     increase_indent();
 
-    out << get_indent() << Style::get_state_type() << " state;" << std::endl;
-    if (0 < reader.getTimeEventCount())
-    {
-        out << get_indent() << "TimeEvents time_events;" << std::endl;
-    }
-    if ((0 < reader.getInEventCount()) || (0 < reader.getTimeEventCount()) || (0 < reader.getInternalEventCount()))
-    {
-        out << get_indent() << "std::deque<Event> event_queue;" << std::endl;
-    }
-    if (0 < reader.getOutEventCount())
-    {
-        out << get_indent() << "std::deque<OutEvent> out_event_queue;" << std::endl;
-    }
-    if (0 < reader.get_variable_count())
-    {
-        out << get_indent() << "Variables variables;" << std::endl;
-    }
-    if (config.do_tracing)
-    {
-        out << get_indent() << "TraceEntry_t trace_enter_function;" << std::endl;
-        out << get_indent() << "TraceExit_t trace_exit_function;" << std::endl;
-    }
-    if (0 < reader.getTimeEventCount())
-    {
-        // time now counter
-        out << get_indent() << "size_t time_now_ms;" << std::endl;
-    }
-    out << get_indent() << "Event active_event;" << std::endl;
-    out << get_indent() << "void " << Style::get_top_run_cycle() << "();" << std::endl;
-    if (config.do_tracing)
-    {
-        out << get_indent() << "void " << Style::get_trace_entry() << "(" << Style::get_state_type() << " state);"
-            << std::endl;
-        out << get_indent() << "void " << Style::get_trace_exit() << "(" << Style::get_state_type() << " state);"
-            << std::endl;
-    }
-    for (auto i = 0u; i < reader.getInternalEventCount(); i++)
-    {
-        auto ev = reader.getInternalEvent(i);
-        if ((nullptr != ev) && ("null" != ev->name))
-        {
-            out << get_indent() << "void " << Style::get_event_raise(ev) << "(";
+    out << get_indent() << "static_assert(0 == (N & (N - 1)), \"the capacity must be a power of two\");" << std::endl;
+    out << get_indent() << "struct Cell" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "std::atomic<size_t> sequence;" << std::endl;
+    out << get_indent() << "T item;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "};" << std::endl;
+    out << get_indent() << "Cell cells[N];" << std::endl;
+    out << get_indent() << "alignas(64) std::atomic<size_t> tail;" << std::endl;
+    out << get_indent() << "alignas(64) size_t head;" << std::endl << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "public:" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "EventIngress() : cells(), tail(), head()" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "for (size_t i = 0; i < N; i++)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "cells[i].sequence.store(i, std::memory_order_relaxed);" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+
+    out << get_indent() << "///\\brief Appends the item, safe from any thread, returns false if the queue is full."
+        << std::endl;
+    out << get_indent() << "bool push(const T& item)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "size_t pos = tail.load(std::memory_order_relaxed);" << std::endl;
+    out << get_indent() << "while (true)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "Cell& cell = cells[pos & (N - 1)];" << std::endl;
+    out << get_indent() << "const size_t sequence = cell.sequence.load(std::memory_order_acquire);" << std::endl;
+    out << get_indent() << "if (sequence == pos)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "cell.item = item;" << std::endl;
+    out << get_indent() << "cell.sequence.store(pos + 1, std::memory_order_release);" << std::endl;
+    out << get_indent() << "return true;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    out << get_indent() << "else if (sequence < pos)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "// the consumer has not freed the cell yet." << std::endl;
+    out << get_indent() << "return false;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    out << get_indent() << "else" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "pos = tail.load(std::memory_order_relaxed);" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+
+    out << get_indent() << "///\\brief Takes the oldest item, only called by the owning thread." << std::endl;
+    out << get_indent() << "bool pop(T& item)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "Cell& cell = cells[head & (N - 1)];" << std::endl;
+    out << get_indent() << "if (cell.sequence.load(std::memory_order_acquire) != (head + 1))" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "return false;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    out << get_indent() << "item = cell.item;" << std::endl;
+    out << get_indent() << "cell.sequence.store(head + N, std::memory_order_release);" << std::endl;
+    out << get_indent() << "head++;" << std::endl;
+    out << get_indent() << "return true;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "};" << std::endl << std::endl;
+}
+
+void Writer::decl_time_event_list(std::ostream& out)
+{
+    const auto n_time_events = reader.getTimeEventCount();
+
+    if ((0 < n_time_events) && is_compact_timers())
+    {
+        out << get_indent() << "struct TimeEvents" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "// One bit for each running timer, the timeouts are constant." << std::endl;
+        out << get_indent() << get_timer_bits_type() << " is_started {};" << std::endl << std::endl;
+        out << get_indent() << "// Expire time of each timer." << std::endl;
+        for (auto i = 0u; i < n_time_events; i++)
+        {
+            auto ev = reader.getTimeEvent(i);
+            if ((nullptr != ev) && ("null" != ev->name))
+            {
+                out << get_indent() << "size_t " << Style::get_event_name(ev) << " {};" << std::endl;
+            }
+        }
+        decrease_indent();
+
+        out << get_indent() << "};" << std::endl << std::endl;
+    }
+    else if (0 < n_time_events)
+    {
+        if (config.shared_runtime)
+        {
+            out << get_indent() << "using TimeEvent = " << Runtime::get_namespace() << "::TimeEvent;" << std::endl
+                << std::endl;
+        }
+        else
+        {
+            out << get_indent() << "struct TimeEvent" << std::endl;
+            out << get_indent() << "{" << std::endl;
+            increase_indent();
+
+            out << get_indent() << "bool is_started {};" << std::endl;
+            out << get_indent() << "bool is_periodic {};" << std::endl;
+            out << get_indent() << "size_t timeout_ms {};" << std::endl;
+            out << get_indent() << "size_t expire_time_ms {};" << std::endl;
+            decrease_indent();
+
+            out << get_indent() << "};" << std::endl << std::endl;
+        }
+
+        out << get_indent() << "struct TimeEvents" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        for (auto i = 0u; i < n_time_events; i++)
+        {
+            auto ev = reader.getTimeEvent(i);
+            if ((nullptr != ev) && ("null" != ev->name))
+            {
+                out << get_indent() << "TimeEvent " << Style::get_event_name(ev) << " {};" << std::endl;
+            }
+        }
+        decrease_indent();
+
+        out << get_indent() << "};" << std::endl << std::endl;
+    }
+}
+
+void Writer::decl_variable_list(std::ostream& out)
+{
+    const auto n_private = reader.getPrivateVariableCount();
+    const auto n_public  = reader.getPublicVariableCount();
+
+    if ((0 == n_private) && (0 == n_public))
+    {
+        // no variables!
+    }
+    else
+    {
+        out << get_indent() << "struct Variables" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        // write private
+        if (0 < n_private)
+        {
+            out << get_indent() << "struct InternalVariables" << std::endl;
+            out << get_indent() << "{" << std::endl;
+            increase_indent();
+
+            for (auto i = 0u; i < n_private; i++)
+            {
+                auto var = reader.getPrivateVariable(i);
+                if ((nullptr != var) && (var->is_private))
+                {
+                    out << get_indent() << var->type << " " << Style::get_variable_name(var) << " {};" << std::endl;
+                }
+            }
+            decrease_indent();
+
+            out << get_indent() << "} internal {};" << std::endl;
+        }
+
+        // write public
+        if (0 < n_public)
+        {
+            out << get_indent() << "struct ExportedVariables" << std::endl;
+            out << get_indent() << "{" << std::endl;
+            increase_indent();
+
+            for (size_t i = 0; i < n_public; i++)
+            {
+                auto var = reader.getPublicVariable(i);
+                if ((nullptr != var) && !var->is_private)
+                {
+                    out << get_indent() << var->type << " " << Style::get_variable_name(var) << " {};" << std::endl;
+                }
+            }
+            decrease_indent();
+
+            out << get_indent() << "} exported {};" << std::endl;
+        }
+        decrease_indent();
+
+        out << get_indent() << "};" << std::endl << std::endl;
+    }
+}
+
+void Writer::decl_tracing_callback(std::ostream& out)
+{
+    if (uses_trace_hook(TraceHook::Pointer))
+    {
+        out << get_indent() << "using TraceEntry_t = void (*)(void* context, " << Style::get_state_type() << " state);"
+            << std::endl;
+        out << get_indent() << "using TraceExit_t = void (*)(void* context, " << Style::get_state_type() << " state);"
+            << std::endl
+            << std::endl;
+    }
+    else if (uses_trace_hook(TraceHook::Function) && config.shared_runtime)
+    {
+        out << get_indent() << "using TraceEntry_t = " << Runtime::get_namespace() << "::TraceCallback<"
+            << Style::get_state_type() << ">;" << std::endl;
+        out << get_indent() << "using TraceExit_t = " << Runtime::get_namespace() << "::TraceCallback<"
+            << Style::get_state_type() << ">;" << std::endl
+            << std::endl;
+    }
+    else if (uses_trace_hook(TraceHook::Function))
+    {
+        out << get_indent() << "using TraceEntry_t = std::function<void(" << Style::get_state_type() << " state)>;"
+            << std::endl;
+        out << get_indent() << "using TraceExit_t = std::function<void(" << Style::get_state_type() << " state)>;"
+            << std::endl
+            << std::endl;
+    }
+}
+
+void Writer::decl_state_machine(std::ostream& out)
+{
+    // write internal structure
+    if (config.lean_header)
+    {
+        out << "///\\brief Private implementation of the " << reader.get_model_name() << " state machine." << std::endl;
+    }
+    else
+    {
+        out << "///\\brief State machine base class for " << reader.get_model_name() << "." << std::endl;
+    }
+    out << get_indent() << "class " << get_class_scope();
+    if (uses_timer_service())
+    {
+        out << " : public " << Runtime::get_namespace() << "::TimerClient";
+    }
+    out << std::endl;
+    out << get_indent() << "{" << std::endl;
+    out << get_indent() << "private:" << std::endl;
+    increase_indent();
+
+    if (config.fleet)
+    {
+        out << get_indent() << "friend class " << get_fleet_name() << ";" << std::endl;
+    }
+    out << get_indent() << Style::get_state_type() << " state;" << std::endl;
+    if (0 < reader.getTimeEventCount())
+    {
+        out << get_indent() << "TimeEvents time_events;" << std::endl;
+    }
+    if ((0 < reader.getInEventCount()) || (0 < reader.getTimeEventCount()) || (0 < reader.getInternalEventCount()))
+    {
+        out << get_indent() << get_queue_type("Event") << " event_queue;" << std::endl;
+    }
+    if (0 < reader.getOutEventCount())
+    {
+        out << get_indent() << get_queue_type(reader.get_model_name() + "_OutEvent") << " out_event_queue;"
+            << std::endl;
+    }
+    if ((0 < config.ingress_capacity) && (0 < reader.getInEventCount()))
+    {
+        out << get_indent() << get_ingress_type() << " ingress;" << std::endl;
+    }
+    if (0 < reader.get_variable_count())
+    {
+        out << get_indent() << "Variables variables;" << std::endl;
+    }
+    if (config.do_tracing && (TraceHook::Static != config.trace_hook))
+    {
+        out << get_indent() << "TraceEntry_t trace_enter_function;" << std::endl;
+        out << get_indent() << "TraceExit_t trace_exit_function;" << std::endl;
+    }
+    if (uses_trace_hook(TraceHook::Pointer))
+    {
+        out << get_indent() << "void* trace_enter_context;" << std::endl;
+        out << get_indent() << "void* trace_exit_context;" << std::endl;
+    }
+    if (config.trace_ring)
+    {
+        out << get_indent() << Runtime::get_namespace() << "::TraceRing* trace_ring;" << std::endl;
+        out << get_indent() << "uint16_t trace_instance;" << std::endl;
+    }
+    if (0 < reader.getTimeEventCount())
+    {
+        // time now counter, the timer service keeps the time of the machines it wakes.
+        if (!uses_timer_service())
+        {
+            out << get_indent() << "size_t time_now_ms;" << std::endl;
+        }
+        if (config.tickless_timers)
+        {
+            out << get_indent() << "size_t timer_deadline_ms;" << std::endl;
+        }
+    }
+    if (uses_timer_service())
+    {
+        out << get_indent() << Runtime::get_namespace() << "::TimerService& timer_service;" << std::endl;
+    }
+    out << get_indent() << "Event active_event;" << std::endl;
+    if (config.instrument)
+    {
+        out << get_indent() << "size_t profile_states[" << get_enum_states().size() << "];" << std::endl;
+        if (!get_profiled_transitions().empty())
+        {
+            out << get_indent() << "size_t profile_transitions[" << get_profiled_transitions().size() << "];"
+                << std::endl;
+        }
+    }
+    out << get_indent() << "void " << Style::get_top_run_cycle() << "();" << std::endl;
+    if (uses_timer_service())
+    {
+        out << get_indent() << "void on_timer(size_t timer) override;" << std::endl;
+    }
+    if (uses_state_trace())
+    {
+        out << get_indent() << "void " << Style::get_trace_entry() << "(" << Style::get_state_type() << " state);"
+            << std::endl;
+        out << get_indent() << "void " << Style::get_trace_exit() << "(" << Style::get_state_type() << " state);"
+            << std::endl;
+    }
+    if (config.trace_ring)
+    {
+        out << get_indent() << "void trace_record(" << Runtime::get_namespace() << "::TraceKind kind, size_t id);"
+            << std::endl;
+        out << get_indent() << "bool trace_guard(size_t transition, bool passed);" << std::endl;
+    }
+    for (auto i = 0u; i < reader.getInternalEventCount(); i++)
+    {
+        auto ev = reader.getInternalEvent(i);
+        if ((nullptr != ev) && ("null" != ev->name))
+        {
+            out << get_indent() << "void " << Style::get_event_raise(ev) << "(";
+            if (ev->require_parameter)
+            {
+                out << ev->parameter_type << " value";
+            }
+            out << ");" << std::endl;
+        }
+    }
+    for (auto i = 0u; i < reader.getOutEventCount(); i++)
+    {
+        auto ev = reader.getOutEvent(i);
+        if ((nullptr != ev) && ("null" != ev->name))
+        {
+            out << get_indent() << "void " << Style::get_event_raise(ev) << "(";
+            if (ev->require_parameter)
+            {
+                out << ev->parameter_type << " value";
+            }
+            out << ");" << std::endl;
+        }
+    }
+    for (auto i = 0u; i < reader.getStateCount(); i++)
+    {
+        auto state = reader.getState(i);
+        if ((nullptr != state) && (0 < entry_functions.bodies.count(state->id)))
+        {
+            out << get_indent() << "void " << styler.get_state_entry(state) << "();" << std::endl;
+        }
+    }
+    for (auto i = 0u; i < reader.getStateCount(); i++)
+    {
+        auto state = reader.getState(i);
+        if ((nullptr != state) && (0 < exit_functions.bodies.count(state->id)))
+        {
+            out << get_indent() << "void " << styler.get_state_exit(state) << "();" << std::endl;
+        }
+    }
+    for (auto i = 0u; i < reader.getStateCount(); i++)
+    {
+        auto state = reader.getState(i);
+        if ((nullptr != state) && (0 < react_functions.bodies.count(state->id)))
+        {
+            out << get_indent() << "bool " << styler.get_state_run_cycle(state) << "(" << get_react_parameters()
+                << ");" << std::endl;
+        }
+    }
+    if (config.table_backend && (1 < tables.guards.size()))
+    {
+        out << get_indent() << "bool check_guard(size_t guard, const Event& event);" << std::endl;
+    }
+    if (config.table_backend && !tables.actions.empty())
+    {
+        out << get_indent() << "void run_action(size_t action);" << std::endl;
+    }
+    for (auto choice : tables.choices)
+    {
+        out << get_indent() << "void " << styler.get_state_choice(choice) << "();" << std::endl;
+    }
+    out << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "public:" << std::endl;
+    increase_indent();
+
+    if (uses_timer_service())
+    {
+        out << get_indent() << "explicit " << get_class_name() << "(" << Runtime::get_namespace()
+            << "::TimerService& service) : ";
+    }
+    else
+    {
+        out << get_indent() << get_class_name() << "() : ";
+    }
+    out << "state()";
+    if (0 < reader.getTimeEventCount())
+    {
+        out << ", time_events()";
+    }
+    if ((0 < reader.getInEventCount()) || (0 < reader.getTimeEventCount()) || (0 < reader.getInternalEventCount()))
+    {
+        out << ", event_queue()";
+    }
+    if (0 < reader.getOutEventCount())
+    {
+        out << ", out_event_queue()";
+    }
+    if ((0 < config.ingress_capacity) && (0 < reader.getInEventCount()))
+    {
+        out << ", ingress()";
+    }
+    if (0 < reader.get_variable_count())
+    {
+        out << ", variables()";
+    }
+    if (uses_trace_hook(TraceHook::Pointer))
+    {
+        // unlike a std::function, a function pointer is left uninitialized by default.
+        out << ", trace_enter_function(), trace_exit_function(), trace_enter_context(), trace_exit_context()";
+    }
+    if (config.trace_ring)
+    {
+        out << ", trace_ring(), trace_instance()";
+    }
+    if ((0 < reader.getTimeEventCount()) && !uses_timer_service())
+    {
+        out << ", time_now_ms()";
+    }
+    if ((0 < reader.getTimeEventCount()) && config.tickless_timers)
+    {
+        out << ", timer_deadline_ms(SIZE_MAX)";
+    }
+    if (uses_timer_service())
+    {
+        out << ", timer_service(service)";
+    }
+    if (config.instrument)
+    {
+        out << ", profile_states()";
+        if (!get_profiled_transitions().empty())
+        {
+            out << ", profile_transitions()";
+        }
+    }
+    out << " {}" << std::endl;
+    if (uses_timer_service())
+    {
+        // the service holds the address of the machine until its timers are cancelled.
+        out << get_indent() << "~" << get_class_name() << "();" << std::endl;
+        out << get_indent() << get_class_name() << "(const " << get_class_name() << "&) = delete;" << std::endl;
+        out << get_indent() << get_class_name() << "(" << get_class_name() << "&&) = delete;" << std::endl;
+        out << get_indent() << get_class_name() << "& operator=(const " << get_class_name() << "&) = delete;"
+            << std::endl;
+        out << get_indent() << get_class_name() << "& operator=(" << get_class_name() << "&&) = delete;"
+            << std::endl;
+    }
+    else
+    {
+        out << get_indent() << "~" << get_class_name() << "() = default;" << std::endl;
+    }
+    // add all prototypes.
+    for (const auto& fn : get_public_functions())
+    {
+        out << get_indent() << get_prototype(fn) << ";" << std::endl;
+    }
+    decrease_indent();
+
+    out << get_indent() << "};" << std::endl << std::endl;
+}
+
+void Writer::decl_lean_interface(std::ostream& out)
+{
+    out << "///\\brief State machine base class for " << reader.get_model_name() << "." << std::endl;
+    out << get_indent() << "class " << reader.get_model_name() << std::endl;
+    out << get_indent() << "{" << std::endl;
+    out << get_indent() << "private:" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "class Impl;" << std::endl;
+    out << get_indent() << "Impl* impl;" << std::endl << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "public:" << std::endl;
+    increase_indent();
+
+    out << get_indent() << reader.get_model_name() << "();" << std::endl;
+    out << get_indent() << "~" << reader.get_model_name() << "();" << std::endl;
+    out << get_indent() << reader.get_model_name() << "(const " << reader.get_model_name() << "&) = delete;"
+        << std::endl;
+    out << get_indent() << reader.get_model_name() << "& operator=(const " << reader.get_model_name()
+        << "&) = delete;" << std::endl;
+    for (const auto& fn : get_public_functions())
+    {
+        out << get_indent() << get_prototype(fn) << ";" << std::endl;
+    }
+    decrease_indent();
+
+    out << get_indent() << "};" << std::endl << std::endl;
+}
+
+void Writer::impl_lean_interface(std::ostream& out)
+{
+    const auto model = reader.get_model_name();
+
+    out << get_indent() << model << "::" << model << "() : impl(new Impl())" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    out << get_indent() << "}" << std::endl << std::endl;
+
+    out << get_indent() << model << "::~" << model << "()" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "delete impl;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+
+    for (const auto& fn : get_public_functions())
+    {
+        out << get_indent() << fn.return_type << " " << model << "::" << fn.name << "(" << fn.parameters << ")";
+        if (fn.is_const)
+        {
+            out << " const";
+        }
+        out << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent();
+        if ("void" != fn.return_type)
+        {
+            out << "return ";
+        }
+        out << (fn.is_static ? "Impl::" : "impl->") << fn.name << "(" << fn.arguments << ");" << std::endl;
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl << std::endl;
+    }
+}
+
+void Writer::decl_fleet(std::ostream& out)
+{
+    if (!config.fleet)
+    {
+        return;
+    }
+
+    if (0 < reader.getTimeEventCount())
+    {
+        out << get_indent() << "struct FleetTimeEvents" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "// Expire time of each timer in each instance, SIZE_MAX if the timer is stopped."
+            << std::endl;
+        for (auto i = 0u; i < reader.getTimeEventCount(); i++)
+        {
+            auto ev = reader.getTimeEvent(i);
+            if ((nullptr != ev) && ("null" != ev->name))
+            {
+                out << get_indent() << "std::vector<size_t> " << Style::get_event_name(ev) << " {};" << std::endl;
+            }
+        }
+        decrease_indent();
+
+        out << get_indent() << "};" << std::endl << std::endl;
+    }
+
+    const auto n_private = reader.getPrivateVariableCount();
+    const auto n_public  = reader.getPublicVariableCount();
+    if ((0 < n_private) || (0 < n_public))
+    {
+        out << get_indent() << "struct FleetVariables" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        if (0 < n_private)
+        {
+            out << get_indent() << "struct InternalVariables" << std::endl;
+            out << get_indent() << "{" << std::endl;
+            increase_indent();
+
+            for (auto i = 0u; i < n_private; i++)
+            {
+                auto var = reader.getPrivateVariable(i);
+                out << get_indent() << "std::vector<" << var->type << "> " << Style::get_variable_name(var) << " {};"
+                    << std::endl;
+            }
+            decrease_indent();
+
+            out << get_indent() << "} internal {};" << std::endl;
+        }
+        if (0 < n_public)
+        {
+            out << get_indent() << "struct ExportedVariables" << std::endl;
+            out << get_indent() << "{" << std::endl;
+            increase_indent();
+
+            for (auto i = 0u; i < n_public; i++)
+            {
+                auto var = reader.getPublicVariable(i);
+                out << get_indent() << "std::vector<" << var->type << "> " << Style::get_variable_name(var) << " {};"
+                    << std::endl;
+            }
+            decrease_indent();
+
+            out << get_indent() << "} exported {};" << std::endl;
+        }
+        decrease_indent();
+
+        out << get_indent() << "};" << std::endl << std::endl;
+    }
+
+    const bool hasEvents
+        = (0 < reader.getInEventCount()) || (0 < reader.getTimeEventCount()) || (0 < reader.getInternalEventCount());
+
+    out << "///\\brief Instances of the " << reader.get_model_name()
+        << " state machine, with the fields of all instances stored in arrays." << std::endl;
+    out << get_indent() << "class " << get_fleet_name() << std::endl;
+    out << get_indent() << "{" << std::endl;
+    out << get_indent() << "private:" << std::endl;
+    increase_indent();
+
+    out << get_indent() << get_class_name() << " worker;" << std::endl;
+    out << get_indent() << "std::vector<" << Style::get_state_type() << "> states;" << std::endl;
+    out << get_indent() << "std::vector<std::vector<size_t>> state_members;" << std::endl;
+    out << get_indent() << "std::vector<size_t> member_slots;" << std::endl;
+    if (0 < reader.getTimeEventCount())
+    {
+        out << get_indent() << "FleetTimeEvents time_events;" << std::endl;
+    }
+    if (0 < reader.get_variable_count())
+    {
+        out << get_indent() << "FleetVariables variables;" << std::endl;
+    }
+    if (0 < reader.getTimeEventCount())
+    {
+        out << get_indent() << "size_t time_now_ms;" << std::endl;
+        out << get_indent() << "size_t timer_deadline_ms;" << std::endl;
+    }
+    if (0 < reader.getOutEventCount())
+    {
+        out << get_indent() << "std::deque<std::pair<size_t, " << reader.get_model_name() << "_OutEvent>> out_events;"
+            << std::endl;
+    }
+    if (hasEvents)
+    {
+        out << get_indent() << "std::vector<size_t> batch_order;" << std::endl;
+    }
+    out << get_indent() << "void load(size_t id);" << std::endl;
+    out << get_indent() << "void store(size_t id);" << std::endl;
+    out << get_indent() << "void run(size_t id);" << std::endl;
+    if (0 < reader.getTimeEventCount())
+    {
+        out << get_indent() << "void expire_timer(std::vector<size_t>& deadlines, size_t period_ms, EventId timer);"
+            << std::endl;
+    }
+    if (hasEvents)
+    {
+        // the event id indexes the broadcast tables, so only the typed broadcasts and deliveries are public.
+        out << get_indent() << "void broadcast(const Event& event);" << std::endl;
+        out << get_indent() << "void deliver(const Event& event);" << std::endl;
+    }
+    out << get_indent() << "void set_state(size_t id, " << Style::get_state_type() << " state);" << std::endl
+        << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "public:" << std::endl;
+    increase_indent();
+
+    out << get_indent() << get_fleet_name() << "() : worker(), states(), state_members(" << get_enum_states().size()
+        << "), member_slots()";
+    if (0 < reader.getTimeEventCount())
+    {
+        out << ", time_events()";
+    }
+    if (0 < reader.get_variable_count())
+    {
+        out << ", variables()";
+    }
+    if (0 < reader.getTimeEventCount())
+    {
+        out << ", time_now_ms(), timer_deadline_ms(SIZE_MAX)";
+    }
+    if (0 < reader.getOutEventCount())
+    {
+        out << ", out_events()";
+    }
+    if (hasEvents)
+    {
+        out << ", batch_order()";
+    }
+    out << " {}" << std::endl;
+    out << get_indent() << "~" << get_fleet_name() << "() = default;" << std::endl;
+    for (const auto& fn : get_fleet_functions())
+    {
+        out << get_indent() << get_prototype(fn) << ";" << std::endl;
+    }
+    decrease_indent();
+
+    out << get_indent() << "};" << std::endl << std::endl;
+}
+
+void Writer::impl_fleet(std::ostream& out)
+{
+    if (!config.fleet)
+    {
+        return;
+    }
+    const auto fleet = get_fleet_name();
+
+    impl_fleet_load(out);
+    impl_fleet_store(out);
+
+    out << get_indent() << "void " << fleet << "::run(size_t id)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    if ((0 < reader.getInEventCount()) || (0 < reader.getTimeEventCount()) || (0 < reader.getInternalEventCount()))
+    {
+        // a deferred worker handles one event for each run cycle.
+        out << get_indent() << "while (!worker.event_queue.empty())" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "worker." << Style::get_top_run_cycle() << "();" << std::endl;
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl;
+    }
+    out << get_indent() << "store(id);" << std::endl;
+    if (0 < reader.getOutEventCount())
+    {
+        out << std::endl;
+        out << get_indent() << "// Tag the out events with the instance that raised them." << std::endl;
+        out << get_indent() << reader.get_model_name() << "_OutEvent ev {};" << std::endl;
+        out << get_indent() << "while (worker.is_out_event_raised(ev))" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "out_events.emplace_back(id, ev);" << std::endl;
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl;
+    }
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+
+    out << get_indent() << "size_t " << fleet << "::add()" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "const auto id = states.size();" << std::endl;
+    out << get_indent() << "states.emplace_back();" << std::endl;
+    out << get_indent() << "member_slots.push_back(state_members.front().size());" << std::endl;
+    out << get_indent() << "state_members.front().push_back(id);" << std::endl;
+    for (auto i = 0u; i < reader.getTimeEventCount(); i++)
+    {
+        auto ev = reader.getTimeEvent(i);
+        if ((nullptr != ev) && ("null" != ev->name))
+        {
+            out << get_indent() << "time_events." << Style::get_event_name(ev) << ".push_back(SIZE_MAX);" << std::endl;
+        }
+    }
+    for (auto i = 0u; i < reader.getPrivateVariableCount(); i++)
+    {
+        out << get_indent() << "variables.internal." << Style::get_variable_name(reader.getPrivateVariable(i))
+            << ".emplace_back();" << std::endl;
+    }
+    for (auto i = 0u; i < reader.getPublicVariableCount(); i++)
+    {
+        out << get_indent() << "variables.exported." << Style::get_variable_name(reader.getPublicVariable(i))
+            << ".emplace_back();" << std::endl;
+    }
+    out << std::endl;
+    out << get_indent() << "// Start from the fields of a new instance." << std::endl;
+    if (0 < reader.getTimeEventCount())
+    {
+        out << get_indent() << "worker.time_events = TimeEvents();" << std::endl;
+        out << get_indent() << "worker.time_now_ms = time_now_ms;" << std::endl;
+    }
+    if (0 < reader.get_variable_count())
+    {
+        out << get_indent() << "worker.variables = Variables();" << std::endl;
+    }
+    out << get_indent() << "worker.init();" << std::endl;
+    out << get_indent() << "run(id);" << std::endl;
+    out << get_indent() << "return id;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+
+    out << get_indent() << "size_t " << fleet << "::size() const" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "return states.size();" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+
+    out << get_indent() << Style::get_state_type() << " " << fleet << "::get_state(size_t id) const" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "return states[id];" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+
+    out << get_indent() << "size_t " << fleet << "::count_in_state(" << Style::get_state_type() << " state) const"
+        << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "return state_members[static_cast<size_t>(state)].size();" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+
+    impl_fleet_set_state(out);
+
+    impl_fleet_time_tick(out);
+    impl_fleet_dispatch(out);
+    impl_fleet_broadcast(out);
+
+    if (0 < reader.getOutEventCount())
+    {
+        out << get_indent() << "bool " << fleet << "::is_out_event_raised(size_t& id, " << reader.get_model_name()
+            << "_OutEvent& ev)" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "if (out_events.empty())" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "return false;" << std::endl;
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl;
+        out << get_indent() << "id = out_events.front().first;" << std::endl;
+        out << get_indent() << "ev = out_events.front().second;" << std::endl;
+        out << get_indent() << "out_events.pop_front();" << std::endl;
+        out << get_indent() << "return true;" << std::endl;
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl << std::endl;
+    }
+
+    for (auto i = 0u; i < reader.getPublicVariableCount(); i++)
+    {
+        auto var = reader.getPublicVariable(i);
+        out << get_indent() << var->type << " " << fleet << "::get_" << Style::get_variable_name(var)
+            << "(size_t id) const" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "return variables.exported." << Style::get_variable_name(var) << "[id];" << std::endl;
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl << std::endl;
+    }
+
+    impl_fleet_snapshot(out);
+}
+
+void Writer::impl_fleet_snapshot(std::ostream& out)
+{
+    if (!config.fleet_snapshot)
+    {
+        return;
+    }
+    const auto fleet  = get_fleet_name();
+    const auto arrays = get_fleet_arrays();
+
+    std::string record_size {};
+    bool        has_bool = false;
+    for (const auto& array : arrays)
+    {
+        record_size += (record_size.empty() ? "sizeof(" : " + sizeof(") + array.second + ")";
+        has_bool = has_bool || ("bool" == array.second);
+    }
+
+    out << get_indent() << "namespace" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "///\\brief Start of a fleet snapshot, followed by one array per field of the instances."
+        << std::endl;
+    out << get_indent() << "struct FleetSnapshotHeader" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "uint64_t magic;" << std::endl;
+    out << get_indent() << "uint64_t version;" << std::endl;
+    out << get_indent() << "uint64_t layout_hash;" << std::endl;
+    out << get_indent() << "uint64_t record_size;" << std::endl;
+    out << get_indent() << "uint64_t count;" << std::endl;
+    out << get_indent() << "uint64_t time_now_ms;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "};" << std::endl << std::endl;
+
+    out << get_indent() << "// Reads as PLANTFLT on the byte order that wrote the file." << std::endl;
+    out << get_indent() << "constexpr uint64_t fleet_snapshot_magic = 0x544c46544e414c50ull;" << std::endl;
+    out << get_indent() << "constexpr uint64_t fleet_snapshot_version = 1;" << std::endl;
+    out << get_indent() << "constexpr uint64_t fleet_layout_hash = 0x" << std::hex << get_fleet_layout_hash()
+        << std::dec << "ull;" << std::endl;
+    out << get_indent() << "constexpr uint64_t fleet_record_size = " << record_size << ";" << std::endl << std::endl;
+
+    for (size_t i = 1; i < arrays.size(); i++)
+    {
+        out << get_indent() << "static_assert(std::is_trivially_copyable<" << arrays[i].second
+            << ">::value, \"fleet snapshots store the fields as raw bytes\");" << std::endl;
+    }
+    out << std::endl;
+
+    out << get_indent() << "template <typename T>" << std::endl;
+    out << get_indent() << "void write_array(std::ofstream& file, const std::vector<T>& items)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent()
+        << "file.write(reinterpret_cast<const char*>(items.data()), static_cast<std::streamsize>(items.size() * "
+        << "sizeof(T)));" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+
+    if (has_bool)
+    {
+        // std::vector<bool> packs its items into bits, so they are written one by one.
+        out << get_indent() << "void write_array(std::ofstream& file, const std::vector<bool>& items)" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "for (const bool item : items)" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "file.write(reinterpret_cast<const char*>(&item), sizeof(bool));" << std::endl;
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl;
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl << std::endl;
+    }
+
+    out << get_indent() << "template <typename T>" << std::endl;
+    out << get_indent() << "void read_array(const uint8_t*& data, std::vector<T>& items, size_t count)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "items.resize(count);" << std::endl;
+    out << get_indent() << "std::memcpy(items.data(), data, count * sizeof(T));" << std::endl;
+    out << get_indent() << "data += count * sizeof(T);" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    if (has_bool)
+    {
+        out << std::endl;
+        out << get_indent() << "void read_array(const uint8_t*& data, std::vector<bool>& items, size_t count)"
+            << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "items.resize(count);" << std::endl;
+        out << get_indent() << "for (size_t i = 0; i < count; i++)" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "bool item {};" << std::endl;
+        out << get_indent() << "std::memcpy(&item, data, sizeof(bool));" << std::endl;
+        out << get_indent() << "items[i] = item;" << std::endl;
+        out << get_indent() << "data += sizeof(bool);" << std::endl;
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl;
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl;
+    }
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+
+    // save
+    out << get_indent() << "bool " << fleet << "::save(const std::string& path) const" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "std::ofstream file(path, std::ios::binary | std::ios::trunc);" << std::endl;
+    out << get_indent() << "if (!file)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "return false;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+    out << get_indent() << "FleetSnapshotHeader header {};" << std::endl;
+    out << get_indent() << "header.magic = fleet_snapshot_magic;" << std::endl;
+    out << get_indent() << "header.version = fleet_snapshot_version;" << std::endl;
+    out << get_indent() << "header.layout_hash = fleet_layout_hash;" << std::endl;
+    out << get_indent() << "header.record_size = fleet_record_size;" << std::endl;
+    out << get_indent() << "header.count = states.size();" << std::endl;
+    if (0 < reader.getTimeEventCount())
+    {
+        out << get_indent() << "header.time_now_ms = time_now_ms;" << std::endl;
+    }
+    out << get_indent() << "file.write(reinterpret_cast<const char*>(&header), sizeof(header));" << std::endl;
+    for (const auto& array : arrays)
+    {
+        out << get_indent() << "write_array(file, " << array.first << ");" << std::endl;
+    }
+    out << get_indent() << "return static_cast<bool>(file);" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+
+    // restore
+    out << get_indent() << "bool " << fleet << "::restore(const std::string& path)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "const int fd = ::open(path.c_str(), O_RDONLY);" << std::endl;
+    out << get_indent() << "if (fd < 0)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "return false;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    out << get_indent() << "struct stat info {};" << std::endl;
+    out << get_indent()
+        << "if ((0 != ::fstat(fd, &info)) || (static_cast<size_t>(info.st_size) < sizeof(FleetSnapshotHeader)))"
+        << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "::close(fd);" << std::endl;
+    out << get_indent() << "return false;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    out << get_indent() << "const auto size = static_cast<size_t>(info.st_size);" << std::endl;
+    out << get_indent() << "// The mapping is only read, the instances keep copies of the arrays." << std::endl;
+    out << get_indent() << "void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);" << std::endl;
+    out << get_indent() << "::close(fd);" << std::endl;
+    out << get_indent() << "if (MAP_FAILED == mapping)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "return false;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+    out << get_indent() << "// Reject files of another model, version or byte order before touching the instances."
+        << std::endl;
+    out << get_indent() << "const auto* data = static_cast<const uint8_t*>(mapping);" << std::endl;
+    out << get_indent() << "FleetSnapshotHeader header {};" << std::endl;
+    out << get_indent() << "std::memcpy(&header, data, sizeof(header));" << std::endl;
+    out << get_indent() << "const auto payload = size - sizeof(header);" << std::endl;
+    out << get_indent() << "bool is_valid = (fleet_snapshot_magic == header.magic)" << std::endl;
+    out << get_indent() << "    && (fleet_snapshot_version == header.version)" << std::endl;
+    out << get_indent() << "    && (fleet_layout_hash == header.layout_hash)" << std::endl;
+    out << get_indent() << "    && (fleet_record_size == header.record_size)" << std::endl;
+    out << get_indent() << "    && (0 == (payload % fleet_record_size))" << std::endl;
+    out << get_indent() << "    && (header.count == (payload / fleet_record_size));" << std::endl;
+    out << get_indent() << "const auto count = static_cast<size_t>(header.count);" << std::endl;
+    out << get_indent() << "data += sizeof(header);" << std::endl << std::endl;
+    out << get_indent() << "// The state index is rebuilt from the states, so each one must be a state of the model."
+        << std::endl;
+    out << get_indent() << "for (size_t id = 0; is_valid && (id < count); id++)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << Style::get_state_type() << " state {};" << std::endl;
+    out << get_indent() << "std::memcpy(&state, data + (id * sizeof(state)), sizeof(state));" << std::endl;
+    out << get_indent() << "is_valid = (static_cast<size_t>(state) < state_members.size());" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    out << get_indent() << "if (is_valid)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    for (const auto& array : arrays)
+    {
+        out << get_indent() << "read_array(data, " << array.first << ", count);" << std::endl;
+    }
+    if (0 < reader.getTimeEventCount())
+    {
+        out << get_indent() << "time_now_ms = header.time_now_ms;" << std::endl;
+        out << get_indent() << "timer_deadline_ms = SIZE_MAX;" << std::endl;
+    }
+    if (0 < reader.getOutEventCount())
+    {
+        out << get_indent() << "out_events.clear();" << std::endl;
+    }
+    out << std::endl;
+    out << get_indent() << "// Rebuild the state index and the earliest deadline from the arrays." << std::endl;
+    out << get_indent() << "for (auto& members : state_members)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "members.clear();" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    out << get_indent() << "member_slots.resize(count);" << std::endl;
+    out << get_indent() << "for (size_t id = 0; id < count; id++)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "auto& members = state_members[static_cast<size_t>(states[id])];" << std::endl;
+    out << get_indent() << "member_slots[id] = members.size();" << std::endl;
+    out << get_indent() << "members.push_back(id);" << std::endl;
+    for (auto i = 0u; i < reader.getTimeEventCount(); i++)
+    {
+        auto ev = reader.getTimeEvent(i);
+        if ((nullptr != ev) && ("null" != ev->name))
+        {
+            out << get_indent() << "timer_deadline_ms = std::min(timer_deadline_ms, time_events."
+                << Style::get_event_name(ev) << "[id]);" << std::endl;
+        }
+    }
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    out << get_indent() << "::munmap(mapping, size);" << std::endl;
+    out << get_indent() << "return is_valid;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+}
+
+std::vector<std::pair<std::string, std::string>> Writer::get_fleet_arrays()
+{
+    // the order of the arrays in a fleet snapshot, with the type of their items.
+    std::vector<std::pair<std::string, std::string>> arrays {};
+    arrays.emplace_back("states", Style::get_state_type());
+    for (auto i = 0u; i < reader.getTimeEventCount(); i++)
+    {
+        auto ev = reader.getTimeEvent(i);
+        if ((nullptr != ev) && ("null" != ev->name))
+        {
+            arrays.emplace_back("time_events." + Style::get_event_name(ev), "size_t");
+        }
+    }
+    for (auto i = 0u; i < reader.getPrivateVariableCount(); i++)
+    {
+        auto var = reader.getPrivateVariable(i);
+        arrays.emplace_back("variables.internal." + Style::get_variable_name(var), var->type);
+    }
+    for (auto i = 0u; i < reader.getPublicVariableCount(); i++)
+    {
+        auto var = reader.getPublicVariable(i);
+        arrays.emplace_back("variables.exported." + Style::get_variable_name(var), var->type);
+    }
+    return arrays;
+}
+
+uint64_t Writer::get_fleet_layout_hash()
+{
+    // FNV-1a over everything that decides what the bytes of a fleet snapshot mean.
+    std::string layout = reader.get_model_name() + (config.compact_layout ? " compact" : "");
+    for (auto state : get_enum_states())
+    {
+        layout += " " + styler.get_state_name(state);
+    }
+    for (const auto& array : get_fleet_arrays())
+    {
+        layout += " " + array.second + " " + array.first;
+    }
+
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const auto c : layout)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+void Writer::impl_fleet_load(std::ostream& out)
+{
+    out << get_indent() << "void " << get_fleet_name() << "::load(size_t id)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "worker.state = states[id];" << std::endl;
+    if (0 < reader.getTimeEventCount())
+    {
+        out << get_indent() << "worker.time_now_ms = time_now_ms;" << std::endl;
+    }
+    if (is_compact_timers() && (0 < reader.getTimeEventCount()))
+    {
+        out << get_indent() << "worker.time_events.is_started = 0;" << std::endl;
+    }
+    for (auto i = 0u; i < reader.getTimeEventCount(); i++)
+    {
+        auto ev = reader.getTimeEvent(i);
+        if ((nullptr == ev) || ("null" == ev->name))
+        {
+            continue;
+        }
+        const auto deadline = "time_events." + Style::get_event_name(ev) + "[id]";
+        out << get_indent() << get_timer_expire(ev, "worker.") << " = " << deadline << ";" << std::endl;
+        if (is_compact_timers())
+        {
+            out << get_indent() << "if (SIZE_MAX != " << deadline << ")" << std::endl;
+            out << get_indent() << "{" << std::endl;
+            increase_indent();
+
+            out << get_indent() << "worker.time_events.is_started |= " << get_timer_mask(ev) << ";" << std::endl;
+            decrease_indent();
+
+            out << get_indent() << "}" << std::endl;
+        }
+        else
+        {
+            out << get_indent() << get_timer_running(ev, "worker.") << " = (SIZE_MAX != " << deadline << ");"
+                << std::endl;
+        }
+    }
+    for (auto i = 0u; i < reader.getPrivateVariableCount(); i++)
+    {
+        const auto name = Style::get_variable_name(reader.getPrivateVariable(i));
+        out << get_indent() << "worker.variables.internal." << name << " = variables.internal." << name << "[id];"
+            << std::endl;
+    }
+    for (auto i = 0u; i < reader.getPublicVariableCount(); i++)
+    {
+        const auto name = Style::get_variable_name(reader.getPublicVariable(i));
+        out << get_indent() << "worker.variables.exported." << name << " = variables.exported." << name << "[id];"
+            << std::endl;
+    }
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+}
+
+void Writer::impl_fleet_store(std::ostream& out)
+{
+    out << get_indent() << "void " << get_fleet_name() << "::store(size_t id)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "set_state(id, worker.state);" << std::endl;
+    for (auto i = 0u; i < reader.getTimeEventCount(); i++)
+    {
+        auto ev = reader.getTimeEvent(i);
+        if ((nullptr != ev) && ("null" != ev->name))
+        {
+            out << get_indent() << "time_events." << Style::get_event_name(ev) << "[id] = ("
+                << get_timer_running(ev, "worker.") << ") ? " << get_timer_expire(ev, "worker.") << " : SIZE_MAX;"
+                << std::endl;
+            out << get_indent() << "timer_deadline_ms = std::min(timer_deadline_ms, time_events."
+                << Style::get_event_name(ev) << "[id]);" << std::endl;
+        }
+    }
+    for (auto i = 0u; i < reader.getPrivateVariableCount(); i++)
+    {
+        const auto name = Style::get_variable_name(reader.getPrivateVariable(i));
+        out << get_indent() << "variables.internal." << name << "[id] = worker.variables.internal." << name << ";"
+            << std::endl;
+    }
+    for (auto i = 0u; i < reader.getPublicVariableCount(); i++)
+    {
+        const auto name = Style::get_variable_name(reader.getPublicVariable(i));
+        out << get_indent() << "variables.exported." << name << "[id] = worker.variables.exported." << name << ";"
+            << std::endl;
+    }
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+}
+
+void Writer::impl_fleet_time_tick(std::ostream& out)
+{
+    if (0 == reader.getTimeEventCount())
+    {
+        return;
+    }
+    impl_fleet_expire_timer(out);
+
+    out << get_indent() << "void " << get_fleet_name() << "::" << Style::get_time_tick() << "(size_t time_elapsed_ms)"
+        << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "time_now_ms += time_elapsed_ms;" << std::endl;
+    out << get_indent() << "if (timer_deadline_ms > time_now_ms)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "return;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    out << get_indent() << "// store() lowers the deadline for each timer that a dispatch starts." << std::endl;
+    out << get_indent() << "timer_deadline_ms = SIZE_MAX;" << std::endl;
+    for (auto i = 0u; i < reader.getTimeEventCount(); i++)
+    {
+        auto ev = reader.getTimeEvent(i);
+        if ((nullptr != ev) && ("null" != ev->name))
+        {
+            out << get_indent() << "expire_timer(time_events." << Style::get_event_name(ev) << ", "
+                << (ev->is_periodic ? ev->expire_time_ms : 0) << ", EventId::time_" << Style::get_event_name(ev)
+                << ");" << std::endl;
+        }
+    }
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+}
+
+void Writer::impl_fleet_expire_timer(std::ostream& out)
+{
+    out << get_indent() << "void " << get_fleet_name()
+        << "::expire_timer(std::vector<size_t>& deadlines, size_t period_ms, EventId timer)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "// Only the expired deadlines are dispatched, found a vector at a time." << std::endl;
+    out << get_indent() << "// The earliest of the others is kept, so the ticks before it return at once." << std::endl;
+    out << get_indent() << "size_t next_ms = SIZE_MAX;" << std::endl;
+    out << get_indent() << "size_t id = 0;" << std::endl;
+    out << "#if (SIZE_MAX == UINT64_MAX) && defined(__AVX2__)" << std::endl;
+    impl_fleet_timer_scan(out, "_mm256", "__m256i", 4);
+    out << "#elif (SIZE_MAX == UINT64_MAX) && defined(__SSE4_2__)" << std::endl;
+    impl_fleet_timer_scan(out, "_mm", "__m128i", 2);
+    out << "#endif" << std::endl;
+    out << get_indent() << "for (; id < states.size(); id++)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "if (deadlines[id] <= time_now_ms)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    impl_fleet_timer_expire(out, "id");
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    out << get_indent() << "else" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "next_ms = std::min(next_ms, deadlines[id]);" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    out << get_indent() << "timer_deadline_ms = std::min(timer_deadline_ms, next_ms);" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+}
+
+void Writer::impl_fleet_timer_scan(
+    std::ostream&      out,
+    const std::string& prefix,
+    const std::string& vector,
+    const size_t       lanes)
+{
+    const std::string si = ("_mm" == prefix) ? "_si128" : "_si256";
+
+    out << get_indent() << "// Flip the sign bits, so the signed compare orders the deadlines as unsigned."
+        << std::endl;
+    out << get_indent() << "const auto sign = " << prefix << "_set1_epi64x(INT64_MIN);" << std::endl;
+    out << get_indent() << "const auto now = " << prefix << "_xor" << si << "(" << prefix
+        << "_set1_epi64x(static_cast<long long>(time_now_ms)), sign);" << std::endl;
+    out << get_indent() << "auto next = " << prefix << "_set1_epi64x(INT64_MAX);" << std::endl;
+    out << get_indent() << "for (; (id + " << lanes << ") <= states.size(); id += " << lanes << ")" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "const auto deadline = " << prefix << "_xor" << si << "(" << prefix << "_loadu" << si
+        << "(reinterpret_cast<const " << vector << "*>(deadlines.data() + id)), sign);" << std::endl;
+    out << get_indent() << "const auto later = " << prefix << "_cmpgt_epi64(deadline, now);" << std::endl;
+    out << get_indent() << "// A stopped timer is SIZE_MAX, which never lowers the running minimum." << std::endl;
+    out << get_indent() << "next = " << prefix << "_blendv_epi8(next, deadline, " << prefix << "_and" << si
+        << "(later, " << prefix << "_cmpgt_epi64(next, deadline)));" << std::endl;
+    out << get_indent() << "const auto expired = ~static_cast<uint32_t>(" << prefix << "_movemask_pd(" << prefix
+        << "_cast" << si.substr(1) << "_pd(later))) & " << ((1u << lanes) - 1) << "u;" << std::endl;
+    out << get_indent() << "for (size_t j = 0; (0 != expired) && (j < " << lanes << "); j++)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "if (0 != (expired & (1u << j)))" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    impl_fleet_timer_expire(out, "id + j");
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    out << get_indent() << "alignas(" << (lanes * 8) << ") long long earliest[" << lanes << "] {};" << std::endl;
+    out << get_indent() << prefix << "_store" << si << "(reinterpret_cast<" << vector << "*>(earliest), next);"
+        << std::endl;
+    out << get_indent() << "for (const auto lane : earliest)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "next_ms = std::min(next_ms, static_cast<size_t>(lane ^ INT64_MIN));" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+}
+
+void Writer::impl_fleet_timer_expire(std::ostream& out, const std::string& id)
+{
+    const auto deadline = "deadlines[" + id + "]";
+    out << get_indent() << deadline << " = (0 != period_ms) ? (" << deadline << " + period_ms) : SIZE_MAX;"
+        << std::endl;
+    out << get_indent() << "Event event {};" << std::endl;
+    out << get_indent() << "event.id = timer;" << std::endl;
+    out << get_indent() << "dispatch(" << id << ", event);" << std::endl;
+    out << get_indent() << "// The dispatch may have restarted the timer." << std::endl;
+    out << get_indent() << "next_ms = std::min(next_ms, " << deadline << ");" << std::endl;
+}
+
+void Writer::impl_fleet_dispatch(std::ostream& out)
+{
+    if ((0 == reader.getInEventCount()) && (0 == reader.getTimeEventCount()) && (0 == reader.getInternalEventCount()))
+    {
+        return;
+    }
+    const auto fleet = get_fleet_name();
+
+    for (auto i = 0u; i < reader.getInEventCount(); i++)
+    {
+        auto ev = reader.getInEvent(i);
+        if ((nullptr == ev) || ("null" == ev->name))
+        {
+            continue;
+        }
+        out << get_indent() << "void " << fleet << "::" << Style::get_event_raise(ev) << "(size_t id"
+            << (ev->require_parameter ? ", " + ev->parameter_type + " value" : "") << ")" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "Event event {};" << std::endl;
+        out << get_indent() << "event.id = EventId::in_" << Style::get_event_name(ev) << ";" << std::endl;
+        if (ev->require_parameter)
+        {
+            out << get_indent() << "event.parameter.in_" << Style::get_event_name(ev) << " = value;" << std::endl;
+        }
+        out << get_indent() << "dispatch(id, event);" << std::endl;
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl << std::endl;
+    }
+
+    out << get_indent() << "void " << fleet << "::dispatch(size_t id, const Event& event)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "load(id);" << std::endl;
+    out << get_indent() << "worker.event_queue.push_back(event);" << std::endl;
+    out << get_indent() << "run(id);" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+
+    out << get_indent() << "void " << fleet << "::dispatch(const std::pair<size_t, Event>* events, size_t count)"
+        << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "// Handle instances in the same state together, each keeps the order of its events."
+        << std::endl;
+    out << get_indent() << "batch_order.resize(count);" << std::endl;
+    out << get_indent() << "for (size_t i = 0; i < count; i++)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "batch_order[i] = i;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    out << get_indent() << "std::stable_sort(" << std::endl;
+    increase_indent();
+    increase_indent();
+
+    out << get_indent() << "batch_order.begin()," << std::endl;
+    out << get_indent() << "batch_order.end()," << std::endl;
+    out << get_indent()
+        << "[this, events](size_t a, size_t b) { return states[events[a].first] < states[events[b].first]; });"
+        << std::endl;
+    decrease_indent();
+    decrease_indent();
+
+    out << get_indent() << "for (const auto i : batch_order)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "dispatch(events[i].first, events[i].second);" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+}
+
+void Writer::impl_fleet_broadcast(std::ostream& out)
+{
+    const auto events = get_event_ids();
+    if (events.empty())
+    {
+        return;
+    }
+    const auto fleet  = get_fleet_name();
+    const auto states = get_enum_states();
+    const auto width  = is_fleet_simd() ? 16 : states.size();
+
+    // what the event does in each state, found from the first transition tried for it.
+    std::vector<std::vector<size_t>> kinds(events.size(), std::vector<size_t>(width));
+    std::vector<std::vector<size_t>> targets(events.size(), std::vector<size_t>(width));
+    for (size_t i = 0; i < states.size(); i++)
+    {
+        const auto paths = get_dispatch_paths(states[i]);
+        for (size_t e = 0; e < events.size(); e++)
+        {
+            targets[e][i] = i;
+            kinds[e][i]   = config.instrument ? 2 : 0;
+            for (const auto& path : paths)
+            {
+                const auto tr = path.transition;
+                if (("null" != tr->event.name) && (events[e] != get_event_id(tr)))
+                {
+                    continue;
+                }
+                const auto target = std::find(states.begin(), states.end(), path.target);
+                if (("null" == tr->event.name) || tr->has_guard || !path.actions.empty() || (states.end() == target))
+                {
+                    kinds[e][i] = 2;
+                }
+                else
+                {
+                    kinds[e][i]   = 1;
+                    targets[e][i] = static_cast<size_t>(target - states.begin());
+                }
+                break;
+            }
+        }
+    }
+
+    out << get_indent() << "namespace" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "///\\brief What a broadcast event does in each state, 0 nothing, 1 only sets the state, "
+        << "2 dispatches." << std::endl;
+    out << get_indent() << "alignas(16) constexpr uint8_t broadcast_kinds[" << events.size() << "][" << width
+        << "] = {" << std::endl;
+    increase_indent();
+
+    for (size_t e = 0; e < events.size(); e++)
+    {
+        out << get_indent() << "{";
+        for (size_t i = 0; i < width; i++)
+        {
+            out << (0 == i ? " " : ", ") << kinds[e][i];
+        }
+        out << " }, // " << events[e] << std::endl;
+    }
+    decrease_indent();
+
+    out << get_indent() << "};" << std::endl << std::endl;
+
+    out << get_indent() << "///\\brief State set by a broadcast event that only sets the state." << std::endl;
+    out << get_indent() << "alignas(16) constexpr " << ((states.size() <= 256) ? "uint8_t" : "uint16_t")
+        << " broadcast_targets[" << events.size() << "][" << width << "] = {" << std::endl;
+    increase_indent();
+
+    for (size_t e = 0; e < events.size(); e++)
+    {
+        out << get_indent() << "{";
+        for (size_t i = 0; i < width; i++)
+        {
+            out << (0 == i ? " " : ", ") << targets[e][i];
+        }
+        out << " }, // " << events[e] << std::endl;
+    }
+    decrease_indent();
+
+    out << get_indent() << "};" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+
+    out << get_indent() << "void " << fleet << "::broadcast(const Event& event)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "const auto row = static_cast<size_t>(event.id);" << std::endl;
+    out << get_indent() << "size_t id = 0;" << std::endl;
+    if (is_fleet_simd())
+    {
+        // the compact states are bytes below 16, so a byte shuffle looks up the kinds of a whole vector.
+        out << "#if defined(__AVX2__)" << std::endl;
+        impl_fleet_broadcast_simd(out, "_mm256", "__m256i", 32);
+        out << "#elif defined(__SSSE3__)" << std::endl;
+        impl_fleet_broadcast_simd(out, "_mm", "__m128i", 16);
+        out << "#endif" << std::endl;
+    }
+    out << get_indent() << "for (; id < states.size(); id++)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    impl_fleet_broadcast_visit(out, "id");
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+
+    out << get_indent() << "void " << fleet << "::deliver(const Event& event)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "const auto row = static_cast<size_t>(event.id);" << std::endl << std::endl;
+    out << get_indent() << "// Collect the instances first, handling the event moves them." << std::endl;
+    out << get_indent() << "batch_order.clear();" << std::endl;
+    out << get_indent() << "for (size_t state = 0; state < state_members.size(); state++)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "if (0 != broadcast_kinds[row][state])" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent()
+        << "batch_order.insert(batch_order.end(), state_members[state].begin(), state_members[state].end());"
+        << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    out << get_indent() << "for (const auto id : batch_order)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    impl_fleet_broadcast_visit(out, "id");
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+
+    for (const std::string function : { "broadcast", "deliver" })
+    {
+        for (auto i = 0u; i < reader.getInEventCount(); i++)
+        {
+            auto ev = reader.getInEvent(i);
+            if ((nullptr == ev) || ("null" == ev->name))
+            {
+                continue;
+            }
+            out << get_indent() << "void " << fleet << "::" << function << "_" << Style::get_event_name(ev) << "("
+                << (ev->require_parameter ? ev->parameter_type + " value" : "") << ")" << std::endl;
+            out << get_indent() << "{" << std::endl;
+            increase_indent();
+
+            out << get_indent() << "Event event {};" << std::endl;
+            out << get_indent() << "event.id = EventId::in_" << Style::get_event_name(ev) << ";" << std::endl;
+            if (ev->require_parameter)
+            {
+                out << get_indent() << "event.parameter.in_" << Style::get_event_name(ev) << " = value;"
+                    << std::endl;
+            }
+            out << get_indent() << function << "(event);" << std::endl;
+            decrease_indent();
+
+            out << get_indent() << "}" << std::endl << std::endl;
+        }
+    }
+}
+
+void Writer::impl_fleet_broadcast_visit(std::ostream& out, const std::string& id)
+{
+    out << get_indent() << "const auto current = static_cast<size_t>(states[" << id << "]);" << std::endl;
+    out << get_indent() << "if (1 == broadcast_kinds[row][current])" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "set_state(" << id << ", static_cast<" << Style::get_state_type()
+        << ">(broadcast_targets[row][current]));" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    out << get_indent() << "else if (2 == broadcast_kinds[row][current])" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "dispatch(" << id << ", event);" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+}
+
+void Writer::impl_fleet_set_state(std::ostream& out)
+{
+    out << get_indent() << "void " << get_fleet_name() << "::set_state(size_t id, " << Style::get_state_type()
+        << " state)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "if (states[id] == state)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "return;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+    out << get_indent() << "// Move the last member of the old state into the slot of this instance." << std::endl;
+    out << get_indent() << "auto& from = state_members[static_cast<size_t>(states[id])];" << std::endl;
+    out << get_indent() << "const auto slot = member_slots[id];" << std::endl;
+    out << get_indent() << "from[slot] = from.back();" << std::endl;
+    out << get_indent() << "member_slots[from[slot]] = slot;" << std::endl;
+    out << get_indent() << "from.pop_back();" << std::endl << std::endl;
+    out << get_indent() << "auto& to = state_members[static_cast<size_t>(state)];" << std::endl;
+    out << get_indent() << "member_slots[id] = to.size();" << std::endl;
+    out << get_indent() << "to.push_back(id);" << std::endl;
+    out << get_indent() << "states[id] = state;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+}
+
+void Writer::impl_fleet_broadcast_simd(
+    std::ostream&      out,
+    const std::string& prefix,
+    const std::string& vector,
+    const size_t       lanes)
+{
+    const auto load_row = [&prefix](const std::string& table)
+    {
+        const std::string row = "_mm_load_si128(reinterpret_cast<const __m128i*>(" + table + "[row]))";
+        return ("_mm" == prefix) ? row : ("_mm256_broadcastsi128_si256(" + row + ")");
+    };
+    const auto si = ("_mm" == prefix) ? "_si128" : "_si256";
+
+    out << get_indent() << "auto* packed = reinterpret_cast<uint8_t*>(states.data());" << std::endl;
+    out << get_indent() << "const auto kinds = " << load_row("broadcast_kinds") << ";" << std::endl;
+    out << get_indent() << "for (; (id + " << lanes << ") <= states.size(); id += " << lanes << ")" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "const auto current = " << prefix << "_loadu" << si << "(reinterpret_cast<const " << vector
+        << "*>(packed + id));" << std::endl;
+    out << get_indent() << "const auto kind = " << prefix << "_shuffle_epi8(kinds, current);" << std::endl << std::endl;
+    out << get_indent() << "// Only the instances in a state that handles the event are visited." << std::endl;
+    out << get_indent() << "const auto handled = ~static_cast<uint32_t>(" << prefix << "_movemask_epi8(" << prefix
+        << "_cmpeq_epi8(kind, " << prefix << "_setzero" << si << "())))" << ((32 == lanes) ? "" : " & 0xffffu")
+        << ";" << std::endl;
+    out << get_indent() << "for (size_t j = 0; (0 != handled) && (j < " << lanes << "); j++)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "if (0 != (handled & (1u << j)))" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    impl_fleet_broadcast_visit(out, "id + j");
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+}
+
+bool Writer::is_fleet_simd()
+{
+    // the states of the compact layout are single bytes.
+    return config.compact_layout && (get_enum_states().size() <= 16);
+}
+
+std::vector<std::string> Writer::get_event_ids()
+{
+    // the order of EventId.
+    std::vector<std::string> ids {};
+    for (auto i = 0u; i < reader.getInEventCount(); i++)
+    {
+        auto ev = reader.getInEvent(i);
+        if ((nullptr != ev) && ("null" != ev->name))
+        {
+            ids.push_back("in_" + Style::get_event_name(ev));
+        }
+    }
+    for (auto i = 0u; i < reader.getTimeEventCount(); i++)
+    {
+        auto ev = reader.getTimeEvent(i);
+        if ((nullptr != ev) && ("null" != ev->name))
+        {
+            ids.push_back("time_" + Style::get_event_name(ev));
+        }
+    }
+    for (auto i = 0u; i < reader.getInternalEventCount(); i++)
+    {
+        auto ev = reader.getInternalEvent(i);
+        if ((nullptr != ev) && ("null" != ev->name))
+        {
+            ids.push_back("internal_" + Style::get_event_name(ev));
+        }
+    }
+    return ids;
+}
+
+std::vector<PublicFunction> Writer::get_fleet_functions()
+{
+    std::vector<PublicFunction> functions {};
+    functions.emplace_back("size_t", "add", "", "");
+
+    PublicFunction size("size_t", "size", "", "");
+    size.is_const     = true;
+    size.is_nodiscard = true;
+    functions.push_back(size);
+
+    PublicFunction get_state(Style::get_state_type(), "get_state", "size_t id", "id");
+    get_state.is_const     = true;
+    get_state.is_nodiscard = true;
+    functions.push_back(get_state);
+
+    PublicFunction count_in_state("size_t", "count_in_state", Style::get_state_type() + " state", "state");
+    count_in_state.is_const     = true;
+    count_in_state.is_nodiscard = true;
+    functions.push_back(count_in_state);
+
+    if (0 < reader.getTimeEventCount())
+    {
+        functions.emplace_back("void", Style::get_time_tick(), "size_t time_elapsed_ms", "time_elapsed_ms");
+    }
+    for (auto i = 0u; i < reader.getInEventCount(); i++)
+    {
+        auto ev = reader.getInEvent(i);
+        if ((nullptr != ev) && ("null" != ev->name))
+        {
+            if (ev->require_parameter)
+            {
+                functions.emplace_back(
+                        "void",
+                        Style::get_event_raise(ev),
+                        "size_t id, " + ev->parameter_type + " value",
+                        "id, value");
+            }
+            else
+            {
+                functions.emplace_back("void", Style::get_event_raise(ev), "size_t id", "id");
+            }
+        }
+    }
+    if ((0 < reader.getInEventCount()) || (0 < reader.getTimeEventCount()) || (0 < reader.getInternalEventCount()))
+    {
+        functions.emplace_back("void", "dispatch", "size_t id, const Event& event", "id, event");
+        functions.emplace_back(
+                "void",
+                "dispatch",
+                "const std::pair<size_t, Event>* events, size_t count",
+                "events, count");
+    }
+    for (const std::string function : { "broadcast", "deliver" })
+    {
+        for (auto i = 0u; i < reader.getInEventCount(); i++)
+        {
+            auto ev = reader.getInEvent(i);
+            if ((nullptr != ev) && ("null" != ev->name))
+            {
+                functions.emplace_back(
+                        "void",
+                        function + "_" + Style::get_event_name(ev),
+                        ev->require_parameter ? (ev->parameter_type + " value") : "",
+                        ev->require_parameter ? "value" : "");
+            }
+        }
+    }
+    if (0 < reader.getOutEventCount())
+    {
+        functions.emplace_back(
+                "bool",
+                "is_out_event_raised",
+                "size_t& id, " + reader.get_model_name() + "_OutEvent& ev",
+                "id, ev");
+    }
+    if (config.fleet_snapshot)
+    {
+        PublicFunction save("bool", "save", "const std::string& path", "path");
+        save.is_const     = true;
+        save.is_nodiscard = true;
+        functions.push_back(save);
+
+        PublicFunction restore("bool", "restore", "const std::string& path", "path");
+        restore.is_nodiscard = true;
+        functions.push_back(restore);
+    }
+    for (auto i = 0u; i < reader.getPublicVariableCount(); i++)
+    {
+        auto           var = reader.getPublicVariable(i);
+        PublicFunction getter(var->type, "get_" + Style::get_variable_name(var), "size_t id", "id");
+        getter.is_const     = true;
+        getter.is_nodiscard = true;
+        functions.push_back(getter);
+    }
+
+    return (functions);
+}
+
+std::string Writer::get_fleet_name() const
+{
+    return reader.get_model_name() + "Fleet";
+}
+
+void Writer::impl_init(std::ostream& out, const std::vector<State*>& first_state)
+{
+    out << get_indent() << "void " << get_class_scope() << "::init()" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    // write variable inits
+    out << get_indent() << "// Initialise variables." << std::endl;
+    bool any_specific_inited = false;
+    for (auto i = 0u; i < reader.get_variable_count(); i++)
+    {
+        auto var = reader.get_variable(i);
+        if (var->specific_initial_value)
+        {
+            if (var->is_private)
+            {
+                out << get_indent() << "variables.internal.";
+            }
+            else
+            {
+                out << get_indent() << "variables.exported.";
+            }
+            out << Style::get_variable_name(var) << " = " << var->initial_value << ";" << std::endl;
+            any_specific_inited = true;
+        }
+    }
+    if (!any_specific_inited)
+    {
+        out << get_indent() << "// No variables with specific values defined, all initialised to 0." << std::endl;
+    }
+    out << std::endl;
+
+    // enter first state
+    if (!first_state.empty())
+    {
+        out << get_indent() << "// Set initial state." << std::endl;
+        State* targetState = nullptr;
+        for (auto i : first_state)
+        {
+            targetState = i;
+            if (has_entry_statement(targetState->id))
+            {
+                // write entry call
+                out << get_indent() << get_entry_function(targetState) << "();" << std::endl;
+            }
+        }
+        out << get_indent() << "state = " << styler.get_state_name(targetState) << ";" << std::endl;
+        if (uses_state_trace())
+        {
+            out << get_indent() << get_trace_call_entry(targetState) << std::endl;
+        }
+    }
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+}
+
+void Writer::impl_raise_in_event(std::ostream& out)
+{
+    for (auto i = 0u; i < reader.getInEventCount(); i++)
+    {
+        auto ev = reader.getInEvent(i);
+        if ((nullptr != ev) && ("null" != ev->name))
+        {
+            out << get_indent() << get_raise_in_type() << " " << get_class_scope() << "::" << Style::get_event_raise(ev)
+                << "(";
+            if (ev->require_parameter)
+            {
+                out << ev->parameter_type << " value";
+            }
+            out << ")" << std::endl;
+            out << get_indent() << "{" << std::endl;
+            increase_indent();
+
+            out << get_indent() << "Event event {};" << std::endl;
+            out << get_indent() << "event.id = " << "EventId::in_" << Style::get_event_name(ev) << ";" << std::endl;
+
+            if (ev->require_parameter)
+            {
+                out << get_indent() << "event.parameter.in_" << Style::get_event_name(ev) << " = value;" << std::endl;
+            }
+
+            if (0 < config.ingress_capacity)
+            {
+                // dispatched by the owning thread in drain().
+                out << get_indent() << "return ingress.push(event);" << std::endl;
+            }
+            else if ("bool" == get_raise_in_type())
+            {
+                out << get_indent() << "if (!event_queue.push_back(event))" << std::endl;
+                out << get_indent() << "{" << std::endl;
+                increase_indent();
+
+                out << get_indent() << "return false;" << std::endl;
+                decrease_indent();
+
+                out << get_indent() << "}" << std::endl;
+                if (!config.deferred_dispatch)
+                {
+                    out << get_indent() << Style::get_top_run_cycle() << "();" << std::endl;
+                }
+                out << get_indent() << "return true;" << std::endl;
+            }
+            else
+            {
+                impl_queue_push(out, "event_queue");
+                if (!config.deferred_dispatch)
+                {
+                    out << get_indent() << Style::get_top_run_cycle() << "();" << std::endl;
+                }
+            }
+            decrease_indent();
+
+            out << get_indent() << "}" << std::endl << std::endl;
+        }
+    }
+}
+
+void Writer::impl_raise_out_event(std::ostream& out)
+{
+    for (auto i = 0u; i < reader.getOutEventCount(); i++)
+    {
+        auto ev = reader.getOutEvent(i);
+        if ((nullptr != ev) && ("null" != ev->name))
+        {
+            out << get_indent() << "void " << get_class_scope() << "::" << Style::get_event_raise(ev) << "(";
+            if (ev->require_parameter)
+            {
+                out << ev->parameter_type << " value";
+            }
+            out << ")" << std::endl;
+            out << get_indent() << "{" << std::endl;
+            increase_indent();
+
+            out << get_indent() << reader.get_model_name() << "_OutEvent event {};" << std::endl;
+            out << get_indent() << "event.id = " << reader.get_model_name() << "_OutEventId::" << ev->name << ";"
+                << std::endl;
+
+            if (ev->require_parameter)
+            {
+                out << get_indent() << "event.parameter." << ev->name << " = value;" << std::endl;
+            }
+
+            impl_queue_push(out, "out_event_queue");
+            decrease_indent();
+
+            out << get_indent() << "}" << std::endl << std::endl;
+        }
+    }
+}
+
+void Writer::impl_raise_internal_event(std::ostream& out)
+{
+    for (auto i = 0u; i < reader.getInternalEventCount(); i++)
+    {
+        auto ev = reader.getInternalEvent(i);
+        if ((nullptr != ev) && ("null" != ev->name))
+        {
+            out << get_indent() << "void " << get_class_scope() << "::" << Style::get_event_raise(ev) << "(";
+            if (ev->require_parameter)
+            {
+                out << ev->parameter_type << " value";
+            }
+            out << ")" << std::endl;
+            out << get_indent() << "{" << std::endl;
+            increase_indent();
+
+            out << get_indent() << "Event event {};" << std::endl;
+            out << get_indent() << "event.id = EventId::internal_" << Style::get_event_name(ev) << ";" << std::endl;
+
             if (ev->require_parameter)
             {
-                out << ev->parameter_type << " value";
+                out << get_indent() << "event.parameter.internal_" << Style::get_event_name(ev) << " = value;"
+                    << std::endl;
+            }
+            impl_queue_push(out, "event_queue");
+            decrease_indent();
+
+            out << get_indent() << "}" << std::endl << std::endl;
+        }
+    }
+}
+
+void Writer::impl_queue_push(std::ostream& out, const std::string& queue)
+{
+    if ((0 < queue_capacity) && (QueueOverflow::Assert == queue_overflow))
+    {
+        out << get_indent() << "assert(!" << queue << ".full());" << std::endl;
+    }
+    else if ((0 < queue_capacity) && (QueueOverflow::DropOldest == queue_overflow))
+    {
+        out << get_indent() << "if (" << queue << ".full())" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << queue << ".pop_front();" << std::endl;
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl;
+    }
+
+    // the fixed capacity queue drops the new event when it is still full.
+    out << get_indent() << queue << ".push_back(event);" << std::endl;
+}
+
+void Writer::impl_drain(std::ostream& out)
+{
+    if ((0 == config.ingress_capacity) || (0 == reader.getInEventCount()))
+    {
+        return;
+    }
+
+    out << get_indent() << "size_t " << get_class_scope() << "::drain()" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "size_t count = 0;" << std::endl;
+    out << get_indent() << "Event event {};" << std::endl;
+    out << get_indent() << "while (ingress.pop(event))" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    impl_queue_push(out, "event_queue");
+    if (!config.deferred_dispatch)
+    {
+        out << get_indent() << Style::get_top_run_cycle() << "();" << std::endl;
+    }
+    out << get_indent() << "count++;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    out << get_indent() << "return count;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+}
+
+void Writer::impl_process(std::ostream& out)
+{
+    if (!config.deferred_dispatch)
+    {
+        return;
+    }
+
+    out << get_indent() << "size_t " << get_class_scope() << "::process(size_t max_events)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "for (size_t i = 0; (i < max_events) && !event_queue.empty(); i++)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << Style::get_top_run_cycle() << "();" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    out << get_indent() << "return event_queue.size();" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+
+    out << get_indent() << "size_t " << get_class_scope()
+        << "::process_until(std::chrono::steady_clock::time_point deadline)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "while (!event_queue.empty() && (std::chrono::steady_clock::now() < deadline))"
+        << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << Style::get_top_run_cycle() << "();" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    out << get_indent() << "return event_queue.size();" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+}
+
+void Writer::impl_check_out_event(std::ostream& out)
+{
+    if (0 < reader.getOutEventCount())
+    {
+        out << get_indent() << "bool " << get_class_scope() << "::is_out_event_raised(" << reader.get_model_name()
+            << "_OutEvent& ev)" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "bool pending = false;" << std::endl;
+        out << get_indent() << "if (!out_event_queue.empty())" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "ev = out_event_queue.front();" << std::endl;
+        out << get_indent() << "out_event_queue.pop_front();" << std::endl;
+        out << get_indent() << "pending = true;" << std::endl;
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl;
+        out << get_indent() << "return pending;" << std::endl;
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl << std::endl;
+    }
+}
+
+void Writer::impl_get_variable(std::ostream& out)
+{
+    for (auto i = 0u; i < reader.get_variable_count(); i++)
+    {
+        auto var = reader.getPublicVariable(i);
+        if (nullptr != var)
+        {
+            out << get_indent() << var->type << " " << get_class_scope() << "::get_"
+                << Style::get_variable_name(var) << "() const" << std::endl;
+            out << "{" << std::endl;
+            increase_indent();
+
+            out << get_indent() << "return variables.exported." << Style::get_variable_name(var) << ";" << std::endl;
+            decrease_indent();
+
+            out << "}" << std::endl << std::endl;
+        }
+    }
+}
+
+void Writer::impl_time_tick(std::ostream& out)
+{
+    if ((0 < reader.getTimeEventCount()) && !uses_timer_service())
+    {
+        out << get_indent() << "void " << get_class_scope() << "::" << Style::get_time_tick()
+            << "(size_t time_elapsed_ms)" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "time_now_ms += time_elapsed_ms;" << std::endl << std::endl;
+        impl_timer_expiry(out);
+        if (!config.deferred_dispatch)
+        {
+            out << get_indent() << Style::get_top_run_cycle() << "();" << std::endl;
+        }
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl << std::endl;
+    }
+}
+
+void Writer::impl_timer_expiry(std::ostream& out)
+{
+    if (config.tickless_timers)
+    {
+        out << get_indent() << "// No timer expires before the earliest deadline." << std::endl;
+        out << get_indent() << "if (timer_deadline_ms <= time_now_ms)" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "timer_deadline_ms = SIZE_MAX;" << std::endl;
+    }
+    for (auto i = 0u; i < reader.getTimeEventCount(); i++)
+    {
+        auto ev = reader.getTimeEvent(i);
+        if ((nullptr != ev) && is_compact_timers())
+        {
+            out << get_indent() << "if ((" << get_timer_running(ev, "") << ") && (" << get_timer_expire(ev, "")
+                << " <= time_now_ms))" << std::endl;
+            out << get_indent() << "{" << std::endl;
+            increase_indent();
+
+            out << get_indent() << "// Time events does not carry any parameter." << std::endl;
+            out << get_indent() << "Event event {};" << std::endl;
+            out << get_indent() << "event.id = " << "EventId::time_" << Style::get_event_name(ev) << ";"
+                << std::endl;
+            if (config.trace_ring)
+            {
+                out << get_indent() << get_trace_record("timer_expired", std::to_string(get_timer_index(ev)))
+                    << std::endl;
+            }
+            impl_queue_push(out, "event_queue");
+            out << std::endl;
+
+            // the timeout and reload are known from the diagram.
+            if (ev->is_periodic)
+            {
+                out << get_indent() << "// Reload the periodic timer." << std::endl;
+                out << get_indent() << get_timer_expire(ev, "") << " += " << ev->expire_time_ms << ";" << std::endl;
+            }
+            else
+            {
+                impl_timer_stop(out, ev);
+            }
+            decrease_indent();
+
+            out << get_indent() << "}" << std::endl;
+        }
+        else if ((nullptr != ev) && config.shared_runtime)
+        {
+            out << get_indent() << "if (" << Runtime::get_namespace() << "::expire_timer(time_events."
+                << Style::get_event_name(ev) << ", time_now_ms))" << std::endl;
+            out << get_indent() << "{" << std::endl;
+            increase_indent();
+
+            out << get_indent() << "// Time events does not carry any parameter." << std::endl;
+            out << get_indent() << "Event event {};" << std::endl;
+            out << get_indent() << "event.id = " << "EventId::time_" << Style::get_event_name(ev) << ";"
+                << std::endl;
+            if (config.trace_ring)
+            {
+                out << get_indent() << get_trace_record("timer_expired", std::to_string(get_timer_index(ev)))
+                    << std::endl;
+            }
+            impl_queue_push(out, "event_queue");
+            decrease_indent();
+
+            out << get_indent() << "}" << std::endl;
+        }
+        else if (nullptr != ev)
+        {
+            out << get_indent() << "if (time_events." << Style::get_event_name(ev) << ".is_started)" << std::endl;
+            out << get_indent() << "{" << std::endl;
+            increase_indent();
+
+            out << get_indent() << "if (time_events." << Style::get_event_name(ev)
+                << ".expire_time_ms <= time_now_ms)" << std::endl;
+            out << get_indent() << "{" << std::endl;
+            increase_indent();
+
+            out << get_indent() << "// Time events does not carry any parameter." << std::endl;
+            out << get_indent() << "Event event {};" << std::endl;
+            out << get_indent() << "event.id = " << "EventId::time_" << Style::get_event_name(ev) << ";"
+                << std::endl;
+            if (config.trace_ring)
+            {
+                out << get_indent() << get_trace_record("timer_expired", std::to_string(get_timer_index(ev)))
+                    << std::endl;
+            }
+            impl_queue_push(out, "event_queue");
+            out << std::endl;
+
+            out << get_indent() << "// Check for automatic reload." << std::endl;
+            out << get_indent() << "if (time_events." << Style::get_event_name(ev) << ".is_periodic)" << std::endl;
+            out << get_indent() << "{" << std::endl;
+            increase_indent();
+
+            out << get_indent() << "time_events." << Style::get_event_name(ev) << ".expire_time_ms += time_events."
+                << Style::get_event_name(ev) << ".timeout_ms;" << std::endl;
+            out << get_indent() << "time_events." << Style::get_event_name(ev) << ".is_started = true;"
+                << std::endl;
+            decrease_indent();
+
+            out << get_indent() << "}" << std::endl;
+            out << get_indent() << "else" << std::endl;
+            out << get_indent() << "{" << std::endl;
+            increase_indent();
+
+            out << get_indent() << "time_events." << Style::get_event_name(ev) << ".is_started = false;"
+                << std::endl;
+            decrease_indent();
+
+            out << get_indent() << "}" << std::endl;
+            decrease_indent();
+
+            out << get_indent() << "}" << std::endl;
+            decrease_indent();
+
+            out << get_indent() << "}" << std::endl;
+        }
+        if ((nullptr != ev) && config.tickless_timers)
+        {
+            impl_timer_deadline(out, ev);
+        }
+    }
+    if (config.tickless_timers)
+    {
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl;
+    }
+}
+
+void Writer::impl_next_timeout(std::ostream& out)
+{
+    if (!config.tickless_timers || (0 == reader.getTimeEventCount()))
+    {
+        return;
+    }
+
+    out << get_indent() << "size_t " << get_class_scope() << "::next_timeout_ms()" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    // stopping a timer leaves its deadline behind, so look at the running ones again.
+    out << get_indent() << "timer_deadline_ms = SIZE_MAX;" << std::endl;
+    for (auto i = 0u; i < reader.getTimeEventCount(); i++)
+    {
+        auto ev = reader.getTimeEvent(i);
+        if (nullptr != ev)
+        {
+            impl_timer_deadline(out, ev);
+        }
+    }
+    out << std::endl;
+    out << get_indent() << "if (SIZE_MAX == timer_deadline_ms)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "// No timer is running." << std::endl;
+    out << get_indent() << "return SIZE_MAX;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    out << get_indent() << "return (timer_deadline_ms <= time_now_ms) ? 0 : (timer_deadline_ms - time_now_ms);"
+        << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+}
+
+void Writer::impl_timer_deadline(std::ostream& out, const Event* ev)
+{
+    out << get_indent() << "if (" << get_timer_running(ev, "") << ")" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "timer_deadline_ms = std::min(timer_deadline_ms, " << get_timer_expire(ev, "") << ");"
+        << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+}
+
+void Writer::impl_on_timer(std::ostream& out)
+{
+    if (!uses_timer_service())
+    {
+        return;
+    }
+
+    out << get_indent() << get_class_scope() << "::~" << get_class_name() << "()" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "// The service must never wake a destroyed machine." << std::endl;
+    for (auto i = 0u; i < reader.getTimeEventCount(); i++)
+    {
+        auto ev = reader.getTimeEvent(i);
+        if (nullptr != ev)
+        {
+            impl_timer_cancel(out, ev);
+        }
+    }
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+
+    out << get_indent() << "void " << get_class_scope() << "::on_timer(size_t timer)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "// Every timer is checked, the index only tells that one is due." << std::endl;
+    out << get_indent() << "static_cast<void>(timer);" << std::endl;
+    for (auto i = 0u; i < reader.getTimeEventCount(); i++)
+    {
+        auto ev = reader.getTimeEvent(i);
+        if ((nullptr != ev) && ev->is_periodic)
+        {
+            out << get_indent() << "const auto reload_" << Style::get_event_name(ev) << " = "
+                << get_timer_expire(ev, "") << ";" << std::endl;
+        }
+    }
+    out << get_indent() << "const auto time_now_ms = timer_service.now();" << std::endl << std::endl;
+    impl_timer_expiry(out);
+    if (!config.deferred_dispatch)
+    {
+        out << get_indent() << Style::get_top_run_cycle() << "();" << std::endl;
+    }
+    for (auto i = 0u; i < reader.getTimeEventCount(); i++)
+    {
+        auto ev = reader.getTimeEvent(i);
+        if ((nullptr == ev) || !ev->is_periodic)
+        {
+            continue;
+        }
+        out << std::endl;
+        out << get_indent() << "// Wait for the next period of a timer reloaded by the tick." << std::endl;
+        out << get_indent() << "if ((" << get_timer_running(ev, "") << ") && (" << get_timer_expire(ev, "")
+            << " != reload_" << Style::get_event_name(ev) << "))" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "timer_service.schedule(this, " << get_timer_index(ev) << ", "
+            << get_timer_expire(ev, "") << ");" << std::endl;
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl;
+    }
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+}
+
+void Writer::impl_top_run_cycle(std::ostream& out)
+{
+    size_t writeNumber = 0;
+    out << get_indent() << "void " << get_class_scope() << "::" << Style::get_top_run_cycle() << "()"
+        << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    if (config.deferred_dispatch)
+    {
+        // process() decides how many events are handled.
+        out << get_indent() << "// Handle the oldest queued event." << std::endl;
+        out << get_indent() << "if (!event_queue.empty())" << std::endl;
+    }
+    else
+    {
+        out << get_indent() << "// Handle all queued events." << std::endl;
+        out << get_indent() << "while (!event_queue.empty())" << std::endl;
+    }
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "active_event = event_queue.front();" << std::endl;
+    out << get_indent() << "event_queue.pop_front();" << std::endl << std::endl;
+    if (config.instrument)
+    {
+        out << get_indent() << "profile_states[static_cast<size_t>(state)]++;" << std::endl << std::endl;
+    }
+    if (config.trace_ring)
+    {
+        out << get_indent() << get_trace_record("event_dispatched", "static_cast<size_t>(active_event.id)")
+            << std::endl
+            << std::endl;
+    }
+    out << get_indent() << "switch (state)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    for (auto state : get_definition_order())
+    {
+        if (("initial" == state->name) || ("final" == state->name) || state->is_choice)
+        {
+            // no handling on initial or final states, or choice.
+        }
+        else
+        {
+            out << get_indent() << "case " << styler.get_state_name(state) << ":" << std::endl;
+            increase_indent();
+
+            out << get_indent() << get_react_function(state)
+                << (config.flatten_dispatch ? "(active_event);" : "(active_event, true);") << std::endl;
+            out << get_indent() << "break;" << std::endl << std::endl;
+            decrease_indent();
+        }
+    }
+    if (0 < reader.getStateCount())
+    {
+        out << get_indent() << "default:" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "// Invalid, or final state." << std::endl;
+        out << get_indent() << "break;" << std::endl;
+        decrease_indent();
+    }
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+}
+
+std::vector<DispatchPath> Writer::get_dispatch_paths(State* state)
+{
+    std::vector<State*> chain {};
+    for (auto s = state; nullptr != s; s = reader.getStateById(s->parent))
+    {
+        if (is_parent_first())
+        {
+            chain.insert(chain.begin(), s);
+        }
+        else
+        {
+            chain.push_back(s);
+        }
+    }
+
+    std::vector<DispatchPath> paths {};
+    for (auto source : chain)
+    {
+        for (auto tr : get_transition_order(source))
+        {
+            auto target = reader.getStateById(tr->state_b);
+            if ((nullptr == target) || (("null" == tr->event.name) && ("final" == target->name)))
+            {
+                continue;
+            }
+
+            DispatchPath path {};
+            path.transition = tr;
+            path.source     = source;
+            if ("null" == tr->event.name)
+            {
+                // taken on any event, and only exits the state, like the react functions.
+                if (has_exit_statement(source->id))
+                {
+                    path.actions.push_back(get_exit_function(source) + "();");
+                }
+                paths.push_back(path);
+                continue;
+            }
+            if (get_event_id(tr).empty())
+            {
+                // out events are never dispatched to the machine.
+                continue;
+            }
+
+            if (config.instrument)
+            {
+                path.actions.push_back("profile_transitions[" + std::to_string(get_profile_index(tr)) + "]++;");
+            }
+            if (config.trace_ring)
+            {
+                path.actions.push_back(
+                        get_trace_record("transition_taken", std::to_string(get_transition_index(tr))));
+            }
+
+            // the active state is known here, so exit it and every parent up to the source. Like the react
+            // functions, only a branch below the source with an exit action exits and traces each of its states.
+            bool hasChildExits = false;
+            for (auto s = state; (nullptr != s) && (source->id != s->id); s = reader.getStateById(s->parent))
+            {
+                hasChildExits = hasChildExits || has_exit_statement(s->id);
+            }
+            for (auto s = hasChildExits ? state : source; nullptr != s; s = reader.getStateById(s->parent))
+            {
+                if (has_exit_statement(s->id))
+                {
+                    path.actions.push_back(get_exit_function(s) + "();");
+                }
+                if (uses_state_trace())
+                {
+                    path.actions.push_back(get_trace_call_exit(s));
+                }
+                if (source->id == s->id)
+                {
+                    break;
+                }
+            }
+
+            for (auto entered : find_entry_state(target))
+            {
+                path.target = entered;
+                if (has_entry_statement(entered->id))
+                {
+                    path.actions.push_back(get_entry_function(entered) + "();");
+                }
+                if (uses_state_trace() && !entered->is_choice)
+                {
+                    path.actions.push_back(get_trace_call_entry(entered));
+                }
+            }
+            paths.push_back(path);
+        }
+    }
+    return paths;
+}
+
+std::string Writer::get_event_id(const Transition* tr) const
+{
+    if (tr->event.is_time_event)
+    {
+        return "time_" + Style::get_event_name(&tr->event);
+    }
+    if ("null" == tr->event.name)
+    {
+        return "";
+    }
+    if (EventDirection::Incoming == tr->event.direction)
+    {
+        return "in_" + Style::get_event_name(&tr->event);
+    }
+    if (EventDirection::Internal == tr->event.direction)
+    {
+        return "internal_" + Style::get_event_name(&tr->event);
+    }
+    return "";
+}
+
+bool Writer::is_parent_first() const
+{
+    return config.parent_first_execution;
+}
+
+std::string Writer::get_react_parameters() const
+{
+    if (config.flatten_dispatch)
+    {
+        return "const Event& event";
+    }
+    return "const Event& event, bool try_transition";
+}
+
+void Writer::impl_flat_react_body(std::ostream& out, State* state)
+{
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    const auto numCommentLines = reader.getDeclCount(state->id, Declaration::Comment);
+    for (auto j = 0u; j < numCommentLines; j++)
+    {
+        auto decl = reader.getDeclFromStateId(state->id, Declaration::Comment, j);
+        out << get_indent() << "// " << decl->declaration << std::endl;
+    }
+    if (0 < numCommentLines)
+    {
+        out << std::endl;
+    }
+
+    const auto                     paths = get_dispatch_paths(state);
+    std::vector<const Transition*> transitions {};
+    for (const auto& path : paths)
+    {
+        transitions.push_back(path.transition);
+    }
+    if (!get_event_cases(transitions).empty())
+    {
+        impl_event_switch(out, transitions, [&](size_t j) { impl_flat_path_body(out, state, paths[j]); });
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl;
+        return;
+    }
+
+    for (size_t j = 0; j < paths.size(); j++)
+    {
+        const auto& path = paths[j];
+        const auto  tr   = path.transition;
+        if ("null" == tr->event.name)
+        {
+            out << get_indent() << get_if_else_if(j) << " (true)" << std::endl;
+        }
+        else if (tr->has_guard)
+        {
+            out << get_indent() << get_if_else_if(j) << " ((EventId::" << get_event_id(tr) << " == event.id) && ("
+                << get_guard_check(tr) << "))" << get_branch_hint(tr) << std::endl;
+        }
+        else
+        {
+            out << get_indent() << get_if_else_if(j) << " (EventId::" << get_event_id(tr) << " == event.id)"
+                << get_branch_hint(tr) << std::endl;
+        }
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        impl_flat_path_body(out, state, path);
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl;
+    }
+
+    if (paths.empty())
+    {
+        out << get_indent() << "return false;" << std::endl;
+    }
+    else
+    {
+        out << get_indent() << "else" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "return false;" << std::endl;
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl;
+        out << get_indent() << "return true;" << std::endl;
+    }
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+}
+
+void Writer::impl_flat_path_body(std::ostream& out, State* state, const DispatchPath& path)
+{
+    if (path.source != state)
+    {
+        out << get_indent() << "// From " << styler.get_state_name(path.source) << "." << std::endl;
+    }
+    for (const auto& action : path.actions)
+    {
+        out << get_indent() << action << std::endl;
+    }
+    if ((nullptr != path.target) && path.target->is_choice)
+    {
+        parse_choice_path(out, path.target);
+    }
+    else if (nullptr != path.target)
+    {
+        out << get_indent() << "state = " << styler.get_state_name(path.target) << ";" << std::endl;
+    }
+}
+
+void Writer::build_dispatch_tables()
+{
+    tables = DispatchTables();
+    tables.guards.emplace_back("true");
+
+    // the columns follow the order of EventId.
+    tables.events = get_event_ids();
+
+    const auto states = get_enum_states();
+    for (auto state : states)
+    {
+        const auto paths = get_dispatch_paths(state);
+        for (const auto& column : tables.events)
+        {
+            const auto first = tables.paths.size();
+            for (const auto& path : paths)
+            {
+                const auto tr = path.transition;
+                if (("null" != tr->event.name) && (column != get_event_id(tr)))
+                {
+                    continue;
+                }
+
+                DispatchEntry entry {};
+                if (tr->has_guard)
+                {
+                    const auto guard = get_guard_check(tr);
+                    const auto found = std::find(tables.guards.begin(), tables.guards.end(), guard);
+                    entry.guard      = static_cast<size_t>(found - tables.guards.begin());
+                    if (tables.guards.end() == found)
+                    {
+                        tables.guards.push_back(guard);
+                    }
+                }
+                for (const auto& action : path.actions)
+                {
+                    entry.actions.push_back(add_dispatch_action(action));
+                }
+
+                if ((nullptr != path.target) && path.target->is_choice)
+                {
+                    // the guards of a choice can only be checked when the transition is taken.
+                    entry.actions.push_back(add_dispatch_action(styler.get_state_choice(path.target) + "();"));
+                    if (tables.choices.end() == std::find(tables.choices.begin(), tables.choices.end(), path.target))
+                    {
+                        tables.choices.push_back(path.target);
+                    }
+                }
+                else if (nullptr != path.target)
+                {
+                    const auto found = std::find(states.begin(), states.end(), path.target);
+                    entry.target     = (states.end() == found) ? -1 : static_cast<long>(found - states.begin());
+                }
+                tables.paths.push_back(entry);
+            }
+            tables.cells.emplace_back(first, tables.paths.size() - first);
+        }
+    }
+}
+
+size_t Writer::add_dispatch_action(const std::string& statement)
+{
+    const auto found = std::find(tables.actions.begin(), tables.actions.end(), statement);
+    if (tables.actions.end() != found)
+    {
+        return static_cast<size_t>(found - tables.actions.begin());
+    }
+    tables.actions.push_back(statement);
+    return tables.actions.size() - 1;
+}
+
+void Writer::decl_dispatch_tables(std::ostream& out)
+{
+    const auto states = get_enum_states();
+
+    // the smallest types that fit the tables, so that they stay small in read-only memory.
+    size_t n_actions = 0;
+    for (const auto& path : tables.paths)
+    {
+        n_actions += path.actions.size();
+    }
+    const auto        largest = std::max({ tables.paths.size(), n_actions, tables.guards.size() });
+    const std::string index   = (largest <= UINT16_MAX) ? "uint16_t" : "uint32_t";
+    const std::string target  = (states.size() <= INT16_MAX) ? "int16_t" : "int32_t";
+
+    out << get_indent() << "namespace" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "///\\brief Range of dispatch_paths tried for one state and event." << std::endl;
+    out << get_indent() << "struct DispatchCell" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << index << " first;" << std::endl;
+    out << get_indent() << index << " count;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "};" << std::endl << std::endl;
+
+    out << get_indent() << "///\\brief Guard and actions of a transition, target is -1 when the actions set the state."
+        << std::endl;
+    out << get_indent() << "struct DispatchPath" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << index << " guard;" << std::endl;
+    out << get_indent() << index << " first_action;" << std::endl;
+    out << get_indent() << index << " action_count;" << std::endl;
+    out << get_indent() << target << " target;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "};" << std::endl << std::endl;
+
+    out << get_indent() << "constexpr DispatchCell dispatch_table[" << states.size() << "][" << tables.events.size()
+        << "] = {" << std::endl;
+    increase_indent();
+
+    for (size_t i = 0; i < states.size(); i++)
+    {
+        out << get_indent() << "// " << styler.get_state_name(states[i]) << std::endl;
+        out << get_indent() << "{";
+        for (size_t j = 0; j < tables.events.size(); j++)
+        {
+            const auto& cell = tables.cells[(i * tables.events.size()) + j];
+            out << (0 == j ? " " : ", ") << "{ " << cell.first << ", " << cell.second << " }";
+        }
+        out << " }," << std::endl;
+    }
+    decrease_indent();
+
+    out << get_indent() << "};" << std::endl << std::endl;
+
+    out << get_indent() << "constexpr DispatchPath dispatch_paths[] = {" << std::endl;
+    increase_indent();
+
+    size_t first_action = 0;
+    for (const auto& path : tables.paths)
+    {
+        out << get_indent() << "{ " << path.guard << ", " << first_action << ", " << path.actions.size() << ", "
+            << path.target << " }," << std::endl;
+        first_action += path.actions.size();
+    }
+    if (tables.paths.empty())
+    {
+        // an array can not be empty, nothing refers to this entry.
+        out << get_indent() << "{ 0, 0, 0, -1 }," << std::endl;
+    }
+    decrease_indent();
+
+    out << get_indent() << "};" << std::endl << std::endl;
+
+    out << get_indent() << "constexpr " << index << " dispatch_actions[] = {" << std::endl;
+    increase_indent();
+
+    for (const auto& path : tables.paths)
+    {
+        if (!path.actions.empty())
+        {
+            out << get_indent();
+            for (size_t j = 0; j < path.actions.size(); j++)
+            {
+                out << (0 == j ? "" : " ") << path.actions[j] << ",";
+            }
+            out << std::endl;
+        }
+    }
+    if (0 == n_actions)
+    {
+        out << get_indent() << "0," << std::endl;
+    }
+    decrease_indent();
+
+    out << get_indent() << "};" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+}
+
+void Writer::impl_table_run_cycle(std::ostream& out)
+{
+    out << get_indent() << "void " << get_class_scope() << "::" << Style::get_top_run_cycle() << "()" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    if (config.deferred_dispatch)
+    {
+        out << get_indent() << "// Handle the oldest queued event." << std::endl;
+        out << get_indent() << "if (!event_queue.empty())" << std::endl;
+    }
+    else
+    {
+        out << get_indent() << "// Handle all queued events." << std::endl;
+        out << get_indent() << "while (!event_queue.empty())" << std::endl;
+    }
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "active_event = event_queue.front();" << std::endl;
+    out << get_indent() << "event_queue.pop_front();" << std::endl << std::endl;
+    if (config.instrument)
+    {
+        out << get_indent() << "profile_states[static_cast<size_t>(state)]++;" << std::endl << std::endl;
+    }
+    if (config.trace_ring)
+    {
+        out << get_indent() << get_trace_record("event_dispatched", "static_cast<size_t>(active_event.id)")
+            << std::endl
+            << std::endl;
+    }
+
+    out << get_indent() << "// The first path whose guard holds is taken." << std::endl;
+    out << get_indent()
+        << "const auto& cell = dispatch_table[static_cast<size_t>(state)][static_cast<size_t>(active_event.id)];"
+        << std::endl;
+    out << get_indent() << "for (size_t i = cell.first; i < (cell.first + cell.count); i++)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "const auto& path = dispatch_paths[i];" << std::endl;
+    if (1 < tables.guards.size())
+    {
+        out << get_indent() << "if ((0 == path.guard) || check_guard(path.guard, active_event))" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+    }
+    if (!tables.actions.empty())
+    {
+        out << get_indent() << "for (size_t j = path.first_action; j < (path.first_action + path.action_count); j++)"
+            << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "run_action(dispatch_actions[j]);" << std::endl;
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl;
+    }
+    out << get_indent() << "if (0 <= path.target)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "state = static_cast<" << Style::get_state_type() << ">(path.target);" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    out << get_indent() << "break;" << std::endl;
+    if (1 < tables.guards.size())
+    {
+        decrease_indent();
+        out << get_indent() << "}" << std::endl;
+    }
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+}
+
+void Writer::impl_table_functions(std::ostream& out)
+{
+    if (1 < tables.guards.size())
+    {
+        out << get_indent() << "bool " << get_class_scope()
+            << "::check_guard(size_t guard, [[maybe_unused]] const Event& event)" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "switch (guard)" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        for (size_t i = 1; i < tables.guards.size(); i++)
+        {
+            out << get_indent() << "case " << i << ":" << std::endl;
+            increase_indent();
+
+            out << get_indent() << "return (" << tables.guards[i] << ");" << std::endl << std::endl;
+            decrease_indent();
+        }
+        out << get_indent() << "default:" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "return true;" << std::endl;
+        decrease_indent();
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl;
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl << std::endl;
+    }
+
+    if (!tables.actions.empty())
+    {
+        out << get_indent() << "void " << get_class_scope() << "::run_action(size_t action)" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "switch (action)" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        for (size_t i = 0; i < tables.actions.size(); i++)
+        {
+            out << get_indent() << "case " << i << ":" << std::endl;
+            increase_indent();
+
+            out << get_indent() << tables.actions[i] << std::endl;
+            out << get_indent() << "break;" << std::endl << std::endl;
+            decrease_indent();
+        }
+        out << get_indent() << "default:" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "break;" << std::endl;
+        decrease_indent();
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl;
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl << std::endl;
+    }
+
+    for (auto choice : tables.choices)
+    {
+        out << get_indent() << "void " << get_class_scope() << "::" << styler.get_state_choice(choice) << "()"
+            << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        parse_choice_path(out, choice);
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl << std::endl;
+    }
+}
+
+void Writer::impl_trace_calls(std::ostream& out)
+{
+    if (uses_state_trace())
+    {
+        impl_trace_hook(out, Style::get_trace_entry(), "enter", "entered_state");
+        impl_trace_hook(out, Style::get_trace_exit(), "exit", "exited_state");
+    }
+    if (config.trace_ring)
+    {
+        impl_trace_ring(out);
+    }
+    if (config.do_tracing)
+    {
+        if (TraceHook::Static != config.trace_hook)
+        {
+            impl_trace_setter(out, "enter", "TraceEntry_t");
+            impl_trace_setter(out, "exit", "TraceExit_t");
+        }
+
+        out << get_indent() << "std::string " << get_class_scope() << "::get_state_name("
+            << Style::get_state_type() << " s)" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "switch (s)" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        for (auto i = 0u; i < reader.getStateCount(); i++)
+        {
+            auto s = reader.getState(i);
+            /* Only write down state on actual states that the machine may stay in. */
+            if ((nullptr != s) && ("initial" != s->name) && ("final" != s->name) && (!s->is_choice))
+            {
+                out << get_indent() << "case " << Style::get_state_type() << "::" << styler.get_state_name_pure(s)
+                    << ":" << std::endl;
+                increase_indent();
+
+                out << get_indent() << "return \"" << styler.get_state_name_pure(s) << "\";" << std::endl << std::endl;
+                decrease_indent();
             }
-            out << ");" << std::endl;
         }
+
+        out << get_indent() << "default:" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "// Invalid state." << std::endl;
+        out << get_indent() << "return {};" << std::endl;
+        decrease_indent();
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl;
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl << std::endl;
+
+        out << get_indent() << Style::get_state_type() << " " << get_class_scope() << "::get_state() const"
+            << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "return state;" << std::endl;
+        decrease_indent();
+
+        out << "}" << std::endl << std::endl;
+    }
+}
+
+void Writer::impl_trace_hook(
+    std::ostream&      out,
+    const std::string& function,
+    const std::string& hook,
+    const std::string& state)
+{
+    out << get_indent() << "void " << get_class_scope() << "::" << function << "(" << Style::get_state_type() << " "
+        << state << ")" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    if (config.trace_ring)
+    {
+        increase_indent();
+
+        out << get_indent() << get_trace_record("state_" + hook, "static_cast<size_t>(" + state + ")") << std::endl;
+        decrease_indent();
+    }
+    if (!config.do_tracing)
+    {
+        out << get_indent() << "}" << std::endl << std::endl;
+        return;
+    }
+    if (TraceHook::Static == config.trace_hook)
+    {
+        // without a tracer the hook is empty, and inlining it leaves nothing behind.
+        out << "#if defined(PLANTGEN_TRACER)" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "PLANTGEN_TRACER::" << hook << "(" << state << ");" << std::endl;
+        decrease_indent();
+
+        out << "#else" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "static_cast<void>(" << state << ");" << std::endl;
+        decrease_indent();
+
+        out << "#endif" << std::endl;
+        out << get_indent() << "}" << std::endl << std::endl;
+        return;
     }
-    for (auto i = 0u; i < reader.getOutEventCount(); i++)
+    increase_indent();
+
+    out << get_indent() << "if (nullptr != trace_" << hook << "_function)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    if (TraceHook::Pointer == config.trace_hook)
     {
-        auto ev = reader.getOutEvent(i);
-        if ((nullptr != ev) && ("null" != ev->name))
-        {
-            out << get_indent() << "void " << Style::get_event_raise(ev) << "(";
-            if (ev->require_parameter)
-            {
-                out << ev->parameter_type << " value";
-            }
-            out << ");" << std::endl;
-        }
+        out << get_indent() << "trace_" << hook << "_function(trace_" << hook << "_context, " << state << ");"
+            << std::endl;
     }
-    for (auto i = 0u; i < reader.getStateCount(); i++)
+    else
     {
-        auto state = reader.getState(i);
-        if ((nullptr != state) && ("initial" != state->name) && has_entry_statement(state->id))
-        {
-            out << get_indent() << "void " << styler.get_state_entry(state) << "();" << std::endl;
-        }
+        out << get_indent() << "trace_" << hook << "_function(" << state << ");" << std::endl;
     }
-    for (auto i = 0u; i < reader.getStateCount(); i++)
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+}
+
+void Writer::impl_trace_setter(std::ostream& out, const std::string& hook, const std::string& type)
+{
+    if (TraceHook::Pointer == config.trace_hook)
     {
-        auto state = reader.getState(i);
-        if ((nullptr != state) && ("initial" != state->name) && has_exit_statement(state->id))
-        {
-            out << get_indent() << "void " << styler.get_state_exit(state) << "();" << std::endl;
-        }
+        out << get_indent() << "void " << get_class_scope() << "::set_trace_" << hook << "_callback(" << type << " "
+            << hook << "_cb, void* context)" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "trace_" << hook << "_function = " << hook << "_cb;" << std::endl;
+        out << get_indent() << "trace_" << hook << "_context = context;" << std::endl;
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl << std::endl;
     }
-    for (auto i = 0u; i < reader.getStateCount(); i++)
+    else
     {
-        auto state = reader.getState(i);
-        if ((nullptr != state) && ("initial" == state->name) || ("final" == state->name) || state->is_choice)
-        {
-            // no run cycle for initial, final or choice states.
-        }
-        else
-        {
-            out << get_indent() << "bool " << styler.get_state_run_cycle(state)
-                << "(const Event& event, bool try_transition);" << std::endl;
-        }
+        out << get_indent() << "void " << get_class_scope() << "::set_trace_" << hook << "_callback(const " << type
+            << "& " << hook << "_cb)" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "trace_" << hook << "_function = " << hook << "_cb;" << std::endl;
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl << std::endl;
     }
-    out << std::endl;
+}
+
+bool Writer::uses_trace_hook(TraceHook hook) const
+{
+    return config.do_tracing && (hook == config.trace_hook);
+}
+
+bool Writer::uses_state_trace() const
+{
+    return config.do_tracing || config.trace_ring;
+}
+
+void Writer::impl_trace_ring(std::ostream& out)
+{
+    out << get_indent() << "void " << get_class_scope() << "::set_trace_ring(" << Runtime::get_namespace()
+        << "::TraceRing* ring, uint16_t instance)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "trace_ring = ring;" << std::endl;
+    out << get_indent() << "trace_instance = instance;" << std::endl;
     decrease_indent();
 
-    out << get_indent() << "public:" << std::endl;
+    out << get_indent() << "}" << std::endl << std::endl;
+
+    out << get_indent() << "void " << get_class_scope() << "::trace_record(" << Runtime::get_namespace()
+        << "::TraceKind kind, size_t id)" << std::endl;
+    out << get_indent() << "{" << std::endl;
     increase_indent();
 
-    out << get_indent() << reader.get_model_name() << "() : ";
-    out << "state()";
-    if (0 < reader.getTimeEventCount())
+    out << get_indent() << "if (nullptr != trace_ring)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    // the model id lets the decoder pick the symbol map of each record.
+    out << get_indent() << "trace_ring->record(" << TraceMap::get_model_id(reader.get_model_name())
+        << ", trace_instance, kind, static_cast<uint16_t>(id));" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+
+    out << get_indent() << "bool " << get_class_scope() << "::trace_guard(size_t transition, bool passed)"
+        << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "trace_record(passed ? " << Runtime::get_namespace() << "::TraceKind::guard_passed : "
+        << Runtime::get_namespace() << "::TraceKind::guard_failed, transition);" << std::endl;
+    out << get_indent() << "return passed;" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl << std::endl;
+}
+
+std::string Writer::get_trace_record(const std::string& kind, const std::string& id)
+{
+    return "trace_record(" + Runtime::get_namespace() + "::TraceKind::" + kind + ", " + id + ");";
+}
+
+std::string Writer::get_guard_check(const Transition* tr)
+{
+    if (config.trace_ring)
     {
-        out << ", time_events()";
+        return "trace_guard(" + std::to_string(get_transition_index(tr)) + ", (" + parse_guard(tr->guard) + "))";
     }
-    if ((0 < reader.getInEventCount()) || (0 < reader.getTimeEventCount()) || (0 < reader.getInternalEventCount()))
+    return parse_guard(tr->guard);
+}
+
+size_t Writer::get_transition_index(const Transition* tr)
+{
+    for (auto i = 0u; i < reader.getTransitionCount(); i++)
     {
-        out << ", event_queue()";
+        if (reader.getTransition(i) == tr)
+        {
+            return i;
+        }
     }
-    if (0 < reader.getOutEventCount())
+    return 0;
+}
+
+bool Writer::generate_trace_map(const std::string& path)
+{
+    TraceMap map {};
+    map.set_model(reader.get_model_name());
+    for (auto state : get_enum_states())
     {
-        out << ", out_event_queue()";
+        map.add("state", styler.get_state_name_pure(state));
     }
-    if (0 < reader.get_variable_count())
+    for (const auto& id : get_event_ids())
     {
-        out << ", variables()";
+        map.add("event", id);
     }
-    if (0 < reader.getTimeEventCount())
+    for (auto i = 0u; i < reader.getTransitionCount(); i++)
     {
-        out << ", time_now_ms()";
+        map.add("transition", Profile::get_transition_key(reader, reader.getTransition(i)));
     }
-    out << " {}" << std::endl;
-    out << get_indent() << "~" << reader.get_model_name() << "() = default;" << std::endl;
-    // add all prototypes.
-    if (config.do_tracing)
+    for (auto i = 0u; i < reader.getTimeEventCount(); i++)
     {
-        out << get_indent() << "void set_trace_enter_callback(const TraceEntry_t& enter_cb);" << std::endl;
-        out << get_indent() << "void set_trace_exit_callback(const TraceExit_t& exit_cb);" << std::endl;
-        out << get_indent() << "static std::string get_state_name(" << Style::get_state_type() << " s);" << std::endl;
-        out << get_indent() << "[[nodiscard]] " << Style::get_state_type() << " get_state() const;" << std::endl;
+        map.add("timer", Style::get_event_name(reader.getTimeEvent(i)));
     }
-    out << get_indent() << "void init();" << std::endl;
-    if (0 < reader.getTimeEventCount())
+    return map.generate(path);
+}
+
+void Writer::impl_run_cycle(std::ostream& out)
+{
+    for (auto state : get_definition_order())
     {
-        out << get_indent() << "void " << Style::get_time_tick() << "(" << "size_t time_elapsed_ms);" << std::endl;
+        auto body = react_functions.bodies.find(state->id);
+        if (react_functions.bodies.end() != body)
+        {
+            impl_shared_note(out, react_functions, state);
+            out << get_indent() << get_function_hint(react_functions, state) << "bool " << get_class_scope()
+                << "::" << styler.get_state_run_cycle(state) << "(" << get_react_parameters() << ")" << std::endl;
+            out << body->second << std::endl;
+        }
     }
-    for (auto i = 0u; i < reader.getInEventCount(); i++)
+}
+
+void Writer::impl_react_body(std::ostream& out, State* state)
+{
+    bool isEmptyBody = true;
+    auto startIndent = indent;
+
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    // write comment declaration here if one exists.
+    const auto numCommentLines = reader.getDeclCount(state->id, Declaration::Comment);
+    if (0 < numCommentLines)
     {
-        auto ev = reader.getInEvent(i);
-        if ((nullptr != ev) && ("null" != ev->name))
+        isEmptyBody = false;
+        for (auto j = 0u; j < numCommentLines; j++)
         {
-            out << get_indent() << "void " << Style::get_event_raise(ev) << "(";
-            if (ev->require_parameter)
-            {
-                out << ev->parameter_type << " value";
-            }
-            out << ");" << std::endl;
+            auto decl = reader.getDeclFromStateId(state->id, Declaration::Comment, j);
+            out << get_indent() << "// " << decl->declaration << std::endl;
         }
+        out << std::endl;
     }
-    if (0 < reader.getOutEventCount())
+
+    out << get_indent() << "auto did_transition = try_transition;" << std::endl;
+    out << get_indent() << "if (try_transition)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    const auto   transitions = get_transition_order(state);
+    const size_t nOutTr      = transitions.size();
+
+    // write parent react, child first execution only asks the parent when no transition of the state was taken.
+    auto parentState = reader.getStateById(state->parent);
+    if ((nullptr != parentState) && is_parent_first())
+    {
+        isEmptyBody = false;
+        {
+            out << get_indent() << "if (!" << get_react_function(parentState)
+                << "(event, try_transition))" << std::endl;
+            out << get_indent() << "{" << std::endl;
+            increase_indent();
+        }
+    }
+
+    const std::vector<const Transition*> constTransitions(transitions.begin(), transitions.end());
+    if (0 == nOutTr)
     {
-        out << get_indent() << "bool is_out_event_raised(" << reader.get_model_name() << "_OutEvent& ev);" << std::endl;
+        out << get_indent() << "did_transition = false;" << std::endl;
     }
-    for (auto i = 0u; i < reader.get_variable_count(); i++)
+    else if (!get_event_cases(constTransitions).empty())
     {
-        auto var = reader.getPublicVariable(i);
-        if (nullptr != var)
+        isEmptyBody = false;
+        impl_event_switch(out, constTransitions, [&](size_t j) { impl_transition_body(out, state, transitions[j]); });
+    }
+    else
+    {
+        for (auto j = 0u; j < nOutTr; j++)
         {
-            out << get_indent() << "[[nodiscard]] " << var->type << " get_" << Style::get_variable_name(var)
-                << "() const;" << std::endl;
+            auto tr = transitions[j];
+            if ("null" == tr->event.name)
+            {
+                auto trStB = reader.getStateById(tr->state_b);
+                if (nullptr == trStB)
+                {
+                    error_report("Null transition!", __LINE__);
+                }
+                else if ("final" != trStB->name)
+                {
+                    error_report("Null transition!", __LINE__);
+
+                    // handle as a oncycle transition?
+                    isEmptyBody = false;
+
+                    out << get_indent() << get_if_else_if(j) << " (true)" << std::endl;
+                    out << get_indent() << "{" << std::endl;
+                    increase_indent();
+
+                    // is exit function exists
+                    if (has_exit_statement(state->id))
+                    {
+                        out << get_indent() << get_exit_function(state) << "();" << std::endl;
+                    }
+
+                    decrease_indent();
+                    out << get_indent() << "}" << std::endl;
+                }
+            }
+            else
+            {
+                auto trStB = reader.getStateById(tr->state_b);
+                if (nullptr == trStB)
+                {
+                    error_report("Null transition!", __LINE__);
+                }
+                else
+                {
+                    isEmptyBody = false;
+
+                    if (tr->event.is_time_event)
+                    {
+                        if (tr->has_guard)
+                        {
+                            std::string guardStr = get_guard_check(tr);
+                            out << get_indent() << get_if_else_if(j) << " (("
+                                << "EventId::time_" << Style::get_event_name(&tr->event) << " == event.id) && ("
+                                << guardStr << "))" << get_branch_hint(tr) << std::endl;
+                        }
+                        else
+                        {
+                            out << get_indent() << get_if_else_if(j) << " ("
+                                << "EventId::time_" << Style::get_event_name(&tr->event) << " == event.id)"
+                                << get_branch_hint(tr) << std::endl;
+                        }
+                    }
+                    else
+                    {
+                        if (tr->has_guard)
+                        {
+                            std::string guardStr = get_guard_check(tr);
+                            out << get_indent() << get_if_else_if(j);
+                            if (EventDirection::Incoming == tr->event.direction)
+                            {
+                                out << " ((EventId::in_" << Style::get_event_name(&tr->event)
+                                    << " == event.id) && (";
+                            }
+                            else if (EventDirection::Internal == tr->event.direction)
+                            {
+                                out << " ((EventId::internal_" << Style::get_event_name(&tr->event)
+                                    << " == event.id) && (";
+                            }
+                            else
+                            {
+                                out << " ((EventId::out_" << Style::get_event_name(&tr->event)
+                                    << " == event.id) && (";
+                            }
+                            out << guardStr << "))" << get_branch_hint(tr) << std::endl;
+                        }
+                        else
+                        {
+                            if (EventDirection::Incoming == tr->event.direction)
+                            {
+                                out << get_indent() << get_if_else_if(j) << " (EventId::in_"
+                                    << Style::get_event_name(&tr->event) << " == event.id)"
+                                    << get_branch_hint(tr) << std::endl;
+                            }
+                            else if (EventDirection::Internal == tr->event.direction)
+                            {
+                                out << get_indent() << get_if_else_if(j) << " (EventId::internal_"
+                                    << Style::get_event_name(&tr->event) << " == event.id)"
+                                    << get_branch_hint(tr) << std::endl;
+                            }
+                            else
+                            {
+                                out << get_indent() << get_if_else_if(j) << " (EventId::out_"
+                                    << Style::get_event_name(&tr->event) << " == event.id)"
+                                    << get_branch_hint(tr) << std::endl;
+                            }
+                        }
+                    }
+                    out << get_indent() << "{" << std::endl;
+                    increase_indent();
+
+                    impl_transition_body(out, state, tr);
+                    decrease_indent();
+
+                    out << get_indent() << "}" << std::endl;
+                }
+            }
         }
+
+        out << get_indent() << "else" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "did_transition = false;" << std::endl;
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl;
     }
+
+    if ((nullptr != parentState) && !is_parent_first())
+    {
+        isEmptyBody = false;
+        out << get_indent() << "if (!did_transition)" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
+
+        out << get_indent() << "did_transition = " << get_react_function(parentState) << "(event, try_transition);"
+            << std::endl;
+        decrease_indent();
+
+        out << get_indent() << "}" << std::endl;
+    }
+
+    while (startIndent + 1 < indent)
+    {
+        decrease_indent();
+        out << get_indent() << "}" << std::endl;
+    }
+
+    out << get_indent() << "return did_transition;" << std::endl;
     decrease_indent();
 
-    out << get_indent() << "};" << std::endl << std::endl;
+    out << get_indent() << "}" << std::endl;
 }
 
-void Writer::impl_init(std::ofstream& out, const std::vector<State*>& first_state)
+void Writer::impl_transition_body(std::ostream& out, State* state, Transition* tr)
 {
-    out << get_indent() << "void " << reader.get_model_name() << "::init()" << std::endl;
-    out << get_indent() << "{" << std::endl;
-    increase_indent();
+    auto trStB = reader.getStateById(tr->state_b);
 
-    // write variable inits
-    out << get_indent() << "// Initialise variables." << std::endl;
-    bool any_specific_inited = false;
-    for (auto i = 0u; i < reader.get_variable_count(); i++)
+    if (config.instrument)
     {
-        auto var = reader.get_variable(i);
-        if (var->specific_initial_value)
+        out << get_indent() << "profile_transitions[" << get_profile_index(tr) << "]++;" << std::endl;
+    }
+    if (config.trace_ring)
+    {
+        out << get_indent() << get_trace_record("transition_taken", std::to_string(get_transition_index(tr)))
+            << std::endl;
+    }
+
+    const bool didChildExits = parse_child_exits(out, state, state->id, false);
+
+    if (didChildExits)
+    {
+        // the active states without exit actions below this state still exit it.
+        if ((has_exit_statement(state->id) || uses_state_trace()) && has_leaf_without_exit(state, state->id))
         {
-            if (var->is_private)
+            out << get_indent() << "else" << std::endl;
+            out << get_indent() << "{" << std::endl;
+            increase_indent();
+
+            if (has_exit_statement(state->id))
             {
-                out << get_indent() << "variables.internal.";
+                out << get_indent() << get_exit_function(state) << "();" << std::endl;
             }
-            else
+            if (uses_state_trace())
             {
-                out << get_indent() << "variables.exported.";
+                out << get_indent() << get_trace_call_exit(state) << std::endl;
             }
-            out << Style::get_variable_name(var) << " = " << var->initial_value << ";" << std::endl;
-            any_specific_inited = true;
+            decrease_indent();
+
+            out << get_indent() << "}" << std::endl;
         }
+        out << std::endl;
     }
-    if (!any_specific_inited)
+    else
     {
-        out << get_indent() << "// No variables with specific values defined, all initialised to 0." << std::endl;
+        if (has_exit_statement(state->id))
+        {
+            out << get_indent() << "// Handle super-step exit." << std::endl;
+            out << get_indent() << get_exit_function(state) << "();" << std::endl;
+        }
+        if (uses_state_trace())
+        {
+            out << get_indent() << get_trace_call_exit(state) << std::endl;
+        }
+        /* Extra new-line */
+        if ((has_exit_statement(state->id)) || uses_state_trace())
+        {
+            out << std::endl;
+        }
     }
-    out << std::endl;
 
-    // enter first state
-    if (!first_state.empty())
+    // TODO: do entry actins on all states entered
+    // towards the goal! Might needs some work..
+    auto enteredStates = find_entry_state(trStB);
+
+    if (!enteredStates.empty())
     {
-        out << get_indent() << "// Set initial state." << std::endl;
-        State* targetState = nullptr;
-        for (auto i : first_state)
+        out << get_indent() << "// Handle super-step entry." << std::endl;
+    }
+
+    State* finalState = nullptr;
+    for (auto& enteredState : enteredStates)
+    {
+        finalState = enteredState;
+
+        if (has_entry_statement(finalState->id))
         {
-            targetState = i;
-            if (has_entry_statement(targetState->id))
-            {
-                // write entry call
-                out << get_indent() << styler.get_state_entry(targetState) << "();" << std::endl;
-            }
+            out << get_indent() << get_entry_function(finalState) << "();" << std::endl;
         }
-        out << get_indent() << "state = " << styler.get_state_name(targetState) << ";" << std::endl;
-        if (config.do_tracing)
+
+        if (uses_state_trace())
         {
-            out << get_indent() << get_trace_call_entry(targetState) << std::endl;
+            // Don't trace entering the choice states, since the state does not exist.
+            if (!finalState->is_choice)
+            {
+                out << get_indent() << get_trace_call_entry(finalState) << std::endl;
+            }
         }
     }
-    decrease_indent();
 
-    out << get_indent() << "}" << std::endl << std::endl;
+    // handle choice node?
+    if ((nullptr != finalState) && (finalState->is_choice))
+    {
+        parse_choice_path(out, finalState);
+    }
+    else
+    {
+        out << get_indent() << "state = " << styler.get_state_name(finalState) << ";" << std::endl;
+    }
 }
 
-void Writer::impl_raise_in_event(std::ofstream& out)
+std::vector<std::pair<std::string, std::vector<size_t>>> Writer::get_event_cases(
+    const std::vector<const Transition*>& transitions)
 {
-    for (auto i = 0u; i < reader.getInEventCount(); i++)
+    std::vector<std::pair<std::string, std::vector<size_t>>> cases {};
+    if (!config.event_switch)
     {
-        auto ev = reader.getInEvent(i);
-        if ((nullptr != ev) && ("null" != ev->name))
+        return cases;
+    }
+    for (size_t j = 0; j < transitions.size(); j++)
+    {
+        const auto tr     = transitions[j];
+        const auto target = reader.getStateById(tr->state_b);
+        if ((nullptr != target) && ("null" == tr->event.name) && ("final" == target->name))
         {
-            out << get_indent() << "void " << reader.get_model_name() << "::" << Style::get_event_raise(ev) << "(";
-            if (ev->require_parameter)
-            {
-                out << ev->parameter_type << " value";
-            }
-            out << ")" << std::endl;
-            out << get_indent() << "{" << std::endl;
-            increase_indent();
-
-            out << get_indent() << "Event event {};" << std::endl;
-            out << get_indent() << "event.id = " << "EventId::in_" << Style::get_event_name(ev) << ";" << std::endl;
-
-            if (ev->require_parameter)
-            {
-                out << get_indent() << "event.parameter.in_" << Style::get_event_name(ev) << " = value;" << std::endl;
-            }
-
-            out << get_indent() << "event_queue.push_back(event);" << std::endl;
-            out << get_indent() << Style::get_top_run_cycle() << "();" << std::endl;
-            decrease_indent();
+            // never taken by the react functions.
+            continue;
+        }
+        const auto id = get_event_id(tr);
+        if ((nullptr == target) || id.empty())
+        {
+            // completion transitions match any event, keep the if chain.
+            return {};
+        }
 
-            out << get_indent() << "}" << std::endl << std::endl;
+        auto found = std::find_if(
+            cases.begin(),
+            cases.end(),
+            [&id](const std::pair<std::string, std::vector<size_t>>& c) { return id == c.first; });
+        if (cases.end() == found)
+        {
+            cases.emplace_back(id, std::vector<size_t>());
+            found = cases.end() - 1;
         }
+        found->second.push_back(j);
     }
+    return cases;
 }
 
-void Writer::impl_raise_out_event(std::ofstream& out)
+void Writer::impl_event_switch(
+    std::ostream&                         out,
+    const std::vector<const Transition*>& transitions,
+    const std::function<void(size_t)>&    write_body)
 {
-    for (auto i = 0u; i < reader.getOutEventCount(); i++)
+    // the flat react functions return, the recursive ones set did_transition and return it later.
+    const std::string no_transition = config.flatten_dispatch ? "return false;" : "did_transition = false;";
+    const std::string done          = config.flatten_dispatch ? "return true;" : "break;";
+
+    out << get_indent() << "switch (event.id)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    for (const auto& c : get_event_cases(transitions))
     {
-        auto ev = reader.getOutEvent(i);
-        if ((nullptr != ev) && ("null" != ev->name))
+        out << get_indent() << "case EventId::" << c.first << ":" << std::endl;
+        increase_indent();
+
+        bool isGuarded = true;
+        for (size_t k = 0; (k < c.second.size()) && isGuarded; k++)
         {
-            out << get_indent() << "void " << reader.get_model_name() << "::" << Style::get_event_raise(ev) << "(";
-            if (ev->require_parameter)
+            const auto tr = transitions[c.second[k]];
+            isGuarded     = tr->has_guard;
+            if (isGuarded)
             {
-                out << ev->parameter_type << " value";
+                out << get_indent() << get_if_else_if(k) << " (" << get_guard_check(tr) << ")"
+                    << get_branch_hint(tr) << std::endl;
             }
-            out << ")" << std::endl;
-            out << get_indent() << "{" << std::endl;
-            increase_indent();
-
-            out << get_indent() << "OutEvent event {};" << std::endl;
-            out << get_indent() << "event.id = OutEventId::" << Style::get_event_name(ev) << ";" << std::endl;
-
-            if (ev->require_parameter)
+            else if (0 < k)
             {
-                out << get_indent() << "event.parameter." << Style::get_event_name(ev) << " = value;" << std::endl;
+                out << get_indent() << "else" << std::endl;
+            }
+            else
+            {
+                // the only transition tried for this event.
+                write_body(c.second[k]);
+                continue;
             }
+            out << get_indent() << "{" << std::endl;
+            increase_indent();
 
-            out << get_indent() << "out_event_queue.push_back(event);" << std::endl;
+            write_body(c.second[k]);
             decrease_indent();
 
-            out << get_indent() << "}" << std::endl << std::endl;
+            out << get_indent() << "}" << std::endl;
         }
-    }
-}
-
-void Writer::impl_raise_internal_event(std::ofstream& out)
-{
-    for (auto i = 0u; i < reader.getInternalEventCount(); i++)
-    {
-        auto ev = reader.getInternalEvent(i);
-        if ((nullptr != ev) && ("null" != ev->name))
+        if (isGuarded)
         {
-            out << get_indent() << "void " << reader.get_model_name() << "::" << Style::get_event_raise(ev) << "(";
-            if (ev->require_parameter)
-            {
-                out << ev->parameter_type << " value";
-            }
-            out << ")" << std::endl;
+            out << get_indent() << "else" << std::endl;
             out << get_indent() << "{" << std::endl;
             increase_indent();
 
-            out << get_indent() << "Event event {};" << std::endl;
-            out << get_indent() << "event.id = EventId::internal_" << Style::get_event_name(ev) << ";" << std::endl;
-
-            if (ev->require_parameter)
-            {
-                out << get_indent() << "event.parameter.internal_" << Style::get_event_name(ev) << " = value;"
-                    << std::endl;
-            }
-            out << get_indent() << "event_queue.push_back(event);" << std::endl;
+            out << get_indent() << no_transition << std::endl;
             decrease_indent();
 
-            out << get_indent() << "}" << std::endl << std::endl;
+            out << get_indent() << "}" << std::endl;
         }
+        out << get_indent() << done << std::endl << std::endl;
+        decrease_indent();
     }
-}
+    out << get_indent() << "default:" << std::endl;
+    increase_indent();
 
-void Writer::impl_check_out_event(std::ofstream& out)
-{
-    if (0 < reader.getOutEventCount())
+    out << get_indent() << no_transition << std::endl;
+    if (!config.flatten_dispatch)
     {
-        out << get_indent() << "bool " << reader.get_model_name() << "::is_out_event_raised(" << reader.get_model_name()
-            << "_OutEvent& ev)" << std::endl;
-        out << get_indent() << "{" << std::endl;
-        increase_indent();
-
-        out << get_indent() << "bool pending = false;" << std::endl;
-        out << get_indent() << "if (!out_event_queue.empty())" << std::endl;
-        out << get_indent() << "{" << std::endl;
-        increase_indent();
-
-        out << get_indent() << "ev = out_event_queue.front();" << std::endl;
-        out << get_indent() << "out_event_queue.pop_front();" << std::endl;
-        out << get_indent() << "pending = true;" << std::endl;
-        decrease_indent();
-
-        out << get_indent() << "}" << std::endl;
-        out << get_indent() << "return pending;" << std::endl;
-        decrease_indent();
-
-        out << get_indent() << "}" << std::endl << std::endl;
+        out << get_indent() << "break;" << std::endl;
     }
+    decrease_indent();
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
 }
 
-void Writer::impl_get_variable(std::ofstream& out)
+void Writer::impl_entry_action(std::ostream& out)
 {
-    for (auto i = 0u; i < reader.get_variable_count(); i++)
+    for (auto state : get_definition_order())
     {
-        auto var = reader.getPublicVariable(i);
-        if (nullptr != var)
+        auto body = entry_functions.bodies.find(state->id);
+        if (entry_functions.bodies.end() != body)
         {
-            out << get_indent() << var->type << " " << reader.get_model_name() << "::get_"
-                << Style::get_variable_name(var) << "() const" << std::endl;
-            out << "{" << std::endl;
-            increase_indent();
-
-            out << get_indent() << "return variables.exported." << Style::get_variable_name(var) << ";" << std::endl;
-            decrease_indent();
-
-            out << "}" << std::endl << std::endl;
+            impl_shared_note(out, entry_functions, state);
+            out << get_indent() << get_function_hint(entry_functions, state) << "void " << get_class_scope()
+                << "::" << styler.get_state_entry(state) << "()" << std::endl;
+            out << body->second << std::endl;
         }
     }
 }
 
-void Writer::impl_time_tick(std::ofstream& out)
+void Writer::impl_entry_body(std::ostream& out, State* state)
 {
-    if (0 < reader.getTimeEventCount())
+    const auto numDecl   = reader.getDeclCount(state->id, Declaration::Entry);
+    size_t     numTimeEv = 0;
+    for (auto j = 0u; j < reader.getTransitionCountFromStateId(state->id); j++)
     {
-        out << get_indent() << "void " << reader.get_model_name() << "::" << Style::get_time_tick()
-            << "(size_t time_elapsed_ms)" << std::endl;
-        out << get_indent() << "{" << std::endl;
-        increase_indent();
-
-        out << get_indent() << "time_now_ms += time_elapsed_ms;" << std::endl << std::endl;
-        for (auto i = 0u; i < reader.getTimeEventCount(); i++)
+        auto tr = reader.getTransitionFrom(state->id, j);
+        if ((nullptr != tr) && (tr->event.is_time_event))
         {
-            auto ev = reader.getTimeEvent(i);
-            if (nullptr != ev)
-            {
-                out << get_indent() << "if (time_events." << Style::get_event_name(ev) << ".is_started)" << std::endl;
-                out << get_indent() << "{" << std::endl;
-                increase_indent();
+            numTimeEv++;
+        }
+    }
 
-                out << get_indent() << "if (time_events." << Style::get_event_name(ev)
-                    << ".expire_time_ms <= time_now_ms)" << std::endl;
-                out << get_indent() << "{" << std::endl;
-                increase_indent();
+    out << get_indent() << "{" << std::endl;
 
-                out << get_indent() << "// Time events does not carry any parameter." << std::endl;
-                out << get_indent() << "Event event {};" << std::endl;
-                out << get_indent() << "event.id = " << "EventId::time_" << Style::get_event_name(ev) << ";"
-                    << std::endl;
-                out << get_indent() << "event_queue.push_back(event);" << std::endl << std::endl;
+    // start timers
+    size_t writeIndex = 0;
+    increase_indent();
 
-                out << get_indent() << "// Check for automatic reload." << std::endl;
-                out << get_indent() << "if (time_events." << Style::get_event_name(ev) << ".is_periodic)" << std::endl;
-                out << get_indent() << "{" << std::endl;
-                increase_indent();
+    if (uses_timer_service() && (0 < numTimeEv))
+    {
+        out << get_indent() << "// The service keeps the time of the machine." << std::endl;
+        out << get_indent() << "const auto time_now_ms = timer_service.now();" << std::endl << std::endl;
+    }
 
-                out << get_indent() << "time_events." << Style::get_event_name(ev) << ".expire_time_ms += time_events."
-                    << Style::get_event_name(ev) << ".timeout_ms;" << std::endl;
-                out << get_indent() << "time_events." << Style::get_event_name(ev) << ".is_started = true;"
+    for (auto j = 0u; j < reader.getTransitionCountFromStateId(state->id); j++)
+    {
+        auto tr = reader.getTransitionFrom(state->id, j);
+        if ((nullptr != tr) && (tr->event.is_time_event))
+        {
+            out << get_indent() << "/* Start timer " << Style::get_event_name(&tr->event)
+                << " with timeout of " << tr->event.expire_time_ms << " ms. */" << std::endl;
+            if (is_compact_timers())
+            {
+                out << get_indent() << get_timer_expire(&tr->event, "") << " = time_now_ms + "
+                    << tr->event.expire_time_ms << ";" << std::endl;
+                out << get_indent() << "time_events.is_started |= " << get_timer_mask(&tr->event) << ";"
                     << std::endl;
-                decrease_indent();
-
-                out << get_indent() << "}" << std::endl;
-                out << get_indent() << "else" << std::endl;
-                out << get_indent() << "{" << std::endl;
-                increase_indent();
-
-                out << get_indent() << "time_events." << Style::get_event_name(ev) << ".is_started = false;"
+            }
+            else if (config.shared_runtime)
+            {
+                out << get_indent() << Runtime::get_namespace() << "::start_timer(time_events."
+                    << Style::get_event_name(&tr->event) << ", time_now_ms, " << tr->event.expire_time_ms
+                    << ", " << (tr->event.is_periodic ? "true" : "false") << ");" << std::endl;
+            }
+            else
+            {
+                out << get_indent() << "time_events." << Style::get_event_name(&tr->event)
+                    << ".timeout_ms = " << tr->event.expire_time_ms << ";" << std::endl;
+                out << get_indent() << "time_events." << Style::get_event_name(&tr->event)
+                    << ".expire_time_ms = time_now_ms + " << tr->event.expire_time_ms << ";"
                     << std::endl;
-                decrease_indent();
-
-                out << get_indent() << "}" << std::endl;
-                decrease_indent();
+                out << get_indent() << "time_events." << Style::get_event_name(&tr->event)
+                    << ".is_periodic = " << (tr->event.is_periodic ? "true;" : "false;") << std::endl;
+                out << get_indent() << "time_events." << Style::get_event_name(&tr->event)
+                    << ".is_started = true;" << std::endl;
+            }
+            if (config.tickless_timers)
+            {
+                out << get_indent() << "timer_deadline_ms = std::min(timer_deadline_ms, "
+                    << get_timer_expire(&tr->event, "") << ");" << std::endl;
+            }
+            if (uses_timer_service())
+            {
+                out << get_indent() << "timer_service.schedule(this, " << get_timer_index(&tr->event) << ", "
+                    << get_timer_expire(&tr->event, "") << ");" << std::endl;
+            }
+            writeIndex++;
+            if (writeIndex < numTimeEv)
+            {
+                out << std::endl;
+            }
+        }
+    }
 
-                out << get_indent() << "}" << std::endl;
-                decrease_indent();
+    if ((0 < numDecl) && (0 < numTimeEv))
+    {
+        // add a space between the parts
+        out << std::endl;
+    }
 
-                out << get_indent() << "}" << std::endl;
-            }
+    for (auto j = 0u; j < numDecl; j++)
+    {
+        auto decl = reader.getDeclFromStateId(state->id, Declaration::Entry, j);
+        if (Declaration::Entry == decl->type)
+        {
+            parse_declaration(out, decl->declaration);
         }
-        out << get_indent() << Style::get_top_run_cycle() << "();" << std::endl;
-        decrease_indent();
+    }
+    decrease_indent();
 
-        out << get_indent() << "}" << std::endl << std::endl;
+    out << get_indent() << "}" << std::endl;
+}
+
+void Writer::impl_exit_action(std::ostream& out)
+{
+    for (auto state : get_definition_order())
+    {
+        auto body = exit_functions.bodies.find(state->id);
+        if (exit_functions.bodies.end() != body)
+        {
+            impl_shared_note(out, exit_functions, state);
+            out << get_indent() << get_function_hint(exit_functions, state) << "void " << get_class_scope()
+                << "::" << styler.get_state_exit(state) << "()" << std::endl;
+            out << body->second << std::endl;
+        }
     }
 }
 
-void Writer::impl_top_run_cycle(std::ofstream& out)
+void Writer::impl_exit_body(std::ostream& out, State* state)
 {
-    size_t writeNumber = 0;
-    out << get_indent() << "void " << reader.get_model_name() << "::" << Style::get_top_run_cycle() << "()"
-        << std::endl;
-    out << get_indent() << "{" << std::endl;
-    increase_indent();
+    const auto numDecl   = reader.getDeclCount(state->id, Declaration::Exit);
+    size_t     numTimeEv = 0;
+    for (auto j = 0u; j < reader.getTransitionCountFromStateId(state->id); j++)
+    {
+        auto tr = reader.getTransitionFrom(state->id, j);
+        if ((nullptr != tr) && (tr->event.is_time_event))
+        {
+            numTimeEv++;
+        }
+    }
 
-    out << get_indent() << "// Handle all queued events." << std::endl;
-    out << get_indent() << "while (!event_queue.empty())" << std::endl;
     out << get_indent() << "{" << std::endl;
-    increase_indent();
 
-    out << get_indent() << "active_event = event_queue.front();" << std::endl;
-    out << get_indent() << "event_queue.pop_front();" << std::endl << std::endl;
-    out << get_indent() << "switch (state)" << std::endl;
-    out << get_indent() << "{" << std::endl;
+    // stop timers
     increase_indent();
-
-    for (auto i = 0u; i < reader.getStateCount(); i++)
+    for (auto j = 0u; j < reader.getTransitionCountFromStateId(state->id); j++)
     {
-        auto state = reader.getState(i);
-        if (("initial" == state->name) || ("final" == state->name) || state->is_choice)
+        auto tr = reader.getTransitionFrom(state->id, j);
+        if ((nullptr != tr) && (tr->event.is_time_event) && uses_timer_service())
         {
-            // no handling on initial or final states, or choice.
+            impl_timer_cancel(out, &tr->event);
         }
-        else
+        if ((nullptr != tr) && (tr->event.is_time_event) && is_compact_timers())
         {
-            out << get_indent() << "case " << styler.get_state_name(state) << ":" << std::endl;
-            increase_indent();
-
-            out << get_indent() << styler.get_state_run_cycle(state) << "(active_event, true);" << std::endl;
-            out << get_indent() << "break;" << std::endl << std::endl;
-            decrease_indent();
+            impl_timer_stop(out, &tr->event);
+        }
+        else if ((nullptr != tr) && (tr->event.is_time_event) && config.shared_runtime)
+        {
+            out << get_indent() << Runtime::get_namespace() << "::stop_timer(time_events."
+                << Style::get_event_name(&tr->event) << ");" << std::endl;
+        }
+        else if ((nullptr != tr) && (tr->event.is_time_event))
+        {
+            out << get_indent() << "time_events." << Style::get_event_name(&tr->event)
+                << ".is_started = false;" << std::endl;
         }
     }
-    if (0 < reader.getStateCount())
-    {
-        out << get_indent() << "default:" << std::endl;
-        increase_indent();
 
-        out << get_indent() << "// Invalid, or final state." << std::endl;
-        out << get_indent() << "break;" << std::endl;
-        decrease_indent();
+    if ((0 < numDecl) && (0 < numTimeEv))
+    {
+        // add a space between the parts
+        out << std::endl;
     }
-    decrease_indent();
 
-    out << get_indent() << "}" << std::endl;
+    if (0 < numDecl)
+    {
+        for (auto j = 0u; j < numDecl; j++)
+        {
+            auto decl = reader.getDeclFromStateId(state->id, Declaration::Exit, j);
+            if (Declaration::Exit == decl->type)
+            {
+                parse_declaration(out, decl->declaration);
+            }
+        }
+    }
     decrease_indent();
 
     out << get_indent() << "}" << std::endl;
-    decrease_indent();
-
-    out << get_indent() << "}" << std::endl << std::endl;
 }
 
-void Writer::impl_trace_calls(std::ofstream& out)
+void Writer::impl_shared_note(std::ostream& out, const SharedFunctions& functions, const State* state)
 {
-    if (config.do_tracing)
+    std::string others {};
+    for (const auto& owner : functions.owners)
     {
-        out << get_indent() << "void " << reader.get_model_name() << "::" << Style::get_trace_entry() << "("
-            << Style::get_state_type() << " entered_state)" << std::endl;
-        out << get_indent() << "{" << std::endl;
-        increase_indent();
-
-        out << get_indent() << "if (nullptr != trace_enter_function)" << std::endl;
-        out << get_indent() << "{" << std::endl;
-        increase_indent();
-
-        out << get_indent() << "trace_enter_function(entered_state);" << std::endl;
-        decrease_indent();
-
-        out << get_indent() << "}" << std::endl;
-        decrease_indent();
-
-        out << get_indent() << "}" << std::endl << std::endl;
-
-        out << get_indent() << "void " << reader.get_model_name() << "::" << Style::get_trace_exit() << "("
-            << Style::get_state_type() << " exited_state)" << std::endl;
-        out << get_indent() << "{" << std::endl;
-        increase_indent();
-
-        out << get_indent() << "if (nullptr != trace_exit_function)" << std::endl;
-        out << get_indent() << "{" << std::endl;
-        increase_indent();
-
-        out << get_indent() << "trace_exit_function(exited_state);" << std::endl;
-        decrease_indent();
-
-        out << get_indent() << "}" << std::endl;
-        decrease_indent();
-
-        out << get_indent() << "}" << std::endl << std::endl;
-
-        out << get_indent() << "void " << reader.get_model_name()
-            << "::set_trace_enter_callback(const TraceEntry_t& enter_cb)" << std::endl;
-        out << get_indent() << "{" << std::endl;
-        increase_indent();
-
-        out << get_indent() << "trace_enter_function = enter_cb;" << std::endl;
-        decrease_indent();
-
-        out << get_indent() << "}" << std::endl << std::endl;
-
-        out << get_indent() << "void " << reader.get_model_name()
-            << "::set_trace_exit_callback(const TraceExit_t& exit_cb)" << std::endl;
-        out << get_indent() << "{" << std::endl;
-        increase_indent();
-
-        out << get_indent() << "trace_exit_function = exit_cb;" << std::endl;
-        decrease_indent();
-
-        out << get_indent() << "}" << std::endl << std::endl;
-
-        out << get_indent() << "std::string " << reader.get_model_name() << "::get_state_name("
-            << Style::get_state_type() << " s)" << std::endl;
-        out << get_indent() << "{" << std::endl;
-        increase_indent();
-
-        out << get_indent() << "switch (s)" << std::endl;
-        out << get_indent() << "{" << std::endl;
-        increase_indent();
-
-        for (auto i = 0u; i < reader.getStateCount(); i++)
+        if ((state->id == owner.second) && (state->id != owner.first))
         {
-            auto s = reader.getState(i);
-            /* Only write down state on actual states that the machine may stay in. */
-            if ((nullptr != s) && ("initial" != s->name) && ("final" != s->name) && (!s->is_choice))
+            if (!others.empty())
             {
-                out << get_indent() << "case " << Style::get_state_type() << "::" << styler.get_state_name_pure(s)
-                    << ":" << std::endl;
-                increase_indent();
-
-                out << get_indent() << "return \"" << styler.get_state_name_pure(s) << "\";" << std::endl << std::endl;
-                decrease_indent();
+                others += ", ";
             }
+            others += styler.get_state_name(reader.getStateById(owner.first));
         }
-
-        out << get_indent() << "default:" << std::endl;
-        increase_indent();
-
-        out << get_indent() << "// Invalid state." << std::endl;
-        out << get_indent() << "return {};" << std::endl;
-        decrease_indent();
-        decrease_indent();
-
-        out << get_indent() << "}" << std::endl;
-        decrease_indent();
-
-        out << get_indent() << "}" << std::endl << std::endl;
-
-        out << get_indent() << Style::get_state_type() << " " << reader.get_model_name() << "::get_state() const"
-            << std::endl;
-        out << get_indent() << "{" << std::endl;
-        increase_indent();
-
-        out << get_indent() << "return state;" << std::endl;
-        decrease_indent();
-
-        out << "}" << std::endl << std::endl;
+    }
+    if (!others.empty())
+    {
+        out << get_indent() << "// Shared with " << others << "." << std::endl;
     }
 }
 
-void Writer::impl_run_cycle(std::ofstream& out)
+void Writer::find_shared_functions()
 {
+    entry_functions = SharedFunctions();
+    exit_functions  = SharedFunctions();
+    react_functions = SharedFunctions();
+
+    // render at the indentation used inside the namespace, so the bodies can be written as they are.
+    reset_indent();
+    increase_indent();
+
+    std::vector<State*> reactStates {};
     for (auto i = 0u; i < reader.getStateCount(); i++)
     {
         auto state = reader.getState(i);
-        if (("initial" == state->name) || ("final" == state->name) || state->is_choice)
+        if ((nullptr == state) || ("initial" == state->name))
         {
-            // initial, final or choice state, no runcycle
+            // no functions for the initial state.
         }
         else
         {
-            bool isEmptyBody = true;
-            auto startIndent = indent;
-
-            out << get_indent() << "bool " << reader.get_model_name() << "::" << styler.get_state_run_cycle(state)
-                << "(const Event& event, bool try_transition)" << std::endl;
-            out << get_indent() << "{" << std::endl;
-            increase_indent();
-
-            // write comment declaration here if one exists.
-            const auto numCommentLines = reader.getDeclCount(state->id, Declaration::Comment);
-            if (0 < numCommentLines)
+            if (has_entry_statement(state->id))
             {
-                isEmptyBody = false;
-                for (auto j = 0u; j < numCommentLines; j++)
-                {
-                    auto decl = reader.getDeclFromStateId(state->id, Declaration::Comment, j);
-                    out << get_indent() << "// " << decl->declaration << std::endl;
-                }
-                out << std::endl;
+                std::ostringstream body {};
+                impl_entry_body(body, state);
+                share_function(entry_functions, state, body.str());
             }
-
-            out << get_indent() << "auto did_transition = try_transition;" << std::endl;
-            out << get_indent() << "if (try_transition)" << std::endl;
-            out << get_indent() << "{" << std::endl;
-            increase_indent();
-
-            const size_t nOutTr = reader.getTransitionCountFromStateId(state->id);
-
-            // write parent react
-            auto parentState = reader.getStateById(state->parent);
-            if (nullptr != parentState)
+            if (has_exit_statement(state->id))
             {
-                isEmptyBody = false;
-                {
-                    out << get_indent() << "if (!" << styler.get_state_run_cycle(parentState)
-                        << "(event, try_transition))" << std::endl;
-                    out << get_indent() << "{" << std::endl;
-                    increase_indent();
-                }
+                std::ostringstream body {};
+                impl_exit_body(body, state);
+                share_function(exit_functions, state, body.str());
             }
-
-            if (0 == nOutTr)
+            if (("final" != state->name) && !state->is_choice)
             {
-                out << get_indent() << "did_transition = false;" << std::endl;
+                reactStates.push_back(state);
             }
-            else
-            {
-                for (auto j = 0u; j < nOutTr; j++)
-                {
-                    auto tr = reader.getTransitionFrom(state->id, j);
-                    if ("null" == tr->event.name)
-                    {
-                        auto trStB = reader.getStateById(tr->state_b);
-                        if (nullptr == trStB)
-                        {
-                            error_report("Null transition!", __LINE__);
-                        }
-                        else if ("final" != trStB->name)
-                        {
-                            error_report("Null transition!", __LINE__);
+        }
+    }
 
-                            // handle as a oncycle transition?
-                            isEmptyBody = false;
+    // a react body calls the react function of its parent, so parents must be shared first.
+    auto depth = [this](const State* state) {
+        size_t n = 0;
+        for (auto parent = reader.getStateById(state->parent); nullptr != parent;
+             parent      = reader.getStateById(parent->parent))
+        {
+            n++;
+        }
+        return n;
+    };
+    std::stable_sort(reactStates.begin(), reactStates.end(),
+                     [&depth](const State* a, const State* b) { return depth(a) < depth(b); });
+    for (auto state : reactStates)
+    {
+        if (config.table_backend)
+        {
+            // the dispatch tables replace the react functions.
+            break;
+        }
+        std::ostringstream body {};
+        if (config.flatten_dispatch)
+        {
+            impl_flat_react_body(body, state);
+        }
+        else
+        {
+            impl_react_body(body, state);
+        }
+        share_function(react_functions, state, body.str());
+    }
 
-                            out << get_indent() << get_if_else_if(j) << " (true)" << std::endl;
-                            out << get_indent() << "{" << std::endl;
-                            increase_indent();
+    reset_indent();
+}
 
-                            // is exit function exists
-                            if (has_exit_statement(state->id))
-                            {
-                                out << get_indent() << styler.get_state_exit(state) << "();" << std::endl;
-                            }
+void Writer::share_function(SharedFunctions& functions, const State* state, const std::string& body)
+{
+    for (const auto& function : functions.bodies)
+    {
+        if (body == function.second)
+        {
+            functions.owners[state->id] = function.first;
+            return;
+        }
+    }
+    functions.bodies[state->id] = body;
+    functions.owners[state->id] = state->id;
+}
 
-                            decrease_indent();
-                            out << get_indent() << "}" << std::endl;
-                        }
-                    }
-                    else
-                    {
-                        auto trStB = reader.getStateById(tr->state_b);
-                        if (nullptr == trStB)
-                        {
-                            error_report("Null transition!", __LINE__);
-                        }
-                        else
-                        {
-                            isEmptyBody = false;
+const State* Writer::get_function_owner(const SharedFunctions& functions, const State* state)
+{
+    auto owner = functions.owners.find(state->id);
+    if (functions.owners.end() != owner)
+    {
+        auto ownerState = reader.getStateById(owner->second);
+        if (nullptr != ownerState)
+        {
+            return ownerState;
+        }
+    }
+    return state;
+}
 
-                            if (tr->event.is_time_event)
-                            {
-                                if (tr->has_guard)
-                                {
-                                    std::string guardStr = parse_guard(tr->guard);
-                                    out << get_indent() << get_if_else_if(j) << " (("
-                                        << "EventId::time_" << Style::get_event_name(&tr->event) << " == event.id) && ("
-                                        << guardStr << "))" << std::endl;
-                                }
-                                else
-                                {
-                                    out << get_indent() << get_if_else_if(j) << " ("
-                                        << "EventId::time_" << Style::get_event_name(&tr->event) << " == event.id)"
-                                        << std::endl;
-                                }
-                            }
-                            else
-                            {
-                                if (tr->has_guard)
-                                {
-                                    std::string guardStr = parse_guard(tr->guard);
-                                    out << get_indent() << get_if_else_if(j);
-                                    if (EventDirection::Incoming == tr->event.direction)
-                                    {
-                                        out << " ((EventId::in_" << Style::get_event_name(&tr->event)
-                                            << " == event.id) && (";
-                                    }
-                                    else if (EventDirection::Internal == tr->event.direction)
-                                    {
-                                        out << " ((EventId::internal_" << Style::get_event_name(&tr->event)
-                                            << " == event.id) && (";
-                                    }
-                                    else
-                                    {
-                                        out << " ((EventId::out_" << Style::get_event_name(&tr->event)
-                                            << " == event.id) && (";
-                                    }
-                                    out << guardStr << "))" << std::endl;
-                                }
-                                else
-                                {
-                                    if (EventDirection::Incoming == tr->event.direction)
-                                    {
-                                        out << get_indent() << get_if_else_if(j) << " (EventId::in_"
-                                            << Style::get_event_name(&tr->event) << " == event.id)" << std::endl;
-                                    }
-                                    else if (EventDirection::Internal == tr->event.direction)
-                                    {
-                                        out << get_indent() << get_if_else_if(j) << " (EventId::internal_"
-                                            << Style::get_event_name(&tr->event) << " == event.id)" << std::endl;
-                                    }
-                                    else
-                                    {
-                                        out << get_indent() << get_if_else_if(j) << " (EventId::out_"
-                                            << Style::get_event_name(&tr->event) << " == event.id)" << std::endl;
-                                    }
-                                }
-                            }
-                            out << get_indent() << "{" << std::endl;
-                            increase_indent();
+std::string Writer::get_entry_function(const State* state)
+{
+    return styler.get_state_entry(get_function_owner(entry_functions, state));
+}
 
-                            const bool didChildExits = parse_child_exits(out, state, state->id, false);
+std::string Writer::get_exit_function(const State* state)
+{
+    return styler.get_state_exit(get_function_owner(exit_functions, state));
+}
 
-                            if (didChildExits)
-                            {
-                                out << std::endl;
-                            }
-                            else
-                            {
-                                if (has_exit_statement(state->id))
-                                {
-                                    out << get_indent() << "// Handle super-step exit." << std::endl;
-                                    out << get_indent() << styler.get_state_exit(state) << "();" << std::endl;
-                                }
-                                if (config.do_tracing)
-                                {
-                                    out << get_indent() << get_trace_call_exit(state) << std::endl;
-                                }
-                                /* Extra new-line */
-                                if ((has_exit_statement(state->id)) || (config.do_tracing))
-                                {
-                                    out << std::endl;
-                                }
-                            }
+std::string Writer::get_react_function(const State* state)
+{
+    return styler.get_state_run_cycle(get_function_owner(react_functions, state));
+}
 
-                            // TODO: do entry actins on all states entered
-                            // towards the goal! Might needs some work..
-                            auto enteredStates = find_entry_state(trStB);
+void Writer::impl_profile(std::ostream& out)
+{
+    // the keys are written as string literals.
+    auto escape = [](const std::string& str)
+    {
+        std::string escaped {};
+        for (auto c : str)
+        {
+            if (('"' == c) || ('\\' == c))
+            {
+                escaped += '\\';
+            }
+            escaped += c;
+        }
+        return escaped;
+    };
 
-                            if (!enteredStates.empty())
-                            {
-                                out << get_indent() << "// Handle super-step entry." << std::endl;
-                            }
+    const auto states      = get_enum_states();
+    const auto transitions = get_profiled_transitions();
 
-                            State* finalState = nullptr;
-                            for (auto& enteredState : enteredStates)
-                            {
-                                finalState = enteredState;
-
-                                if (has_entry_statement(finalState->id))
-                                {
-                                    out << get_indent() << styler.get_state_entry(finalState) << "();" << std::endl;
-                                }
-
-                                if (config.do_tracing)
-                                {
-                                    // Don't trace entering the choice states, since the state does not exist.
-                                    if (!finalState->is_choice)
-                                    {
-                                        out << get_indent() << get_trace_call_entry(finalState) << std::endl;
-                                    }
-                                }
-                            }
+    out << get_indent() << "std::string " << get_class_scope() << "::get_profile() const" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
 
-                            // handle choice node?
-                            if ((nullptr != finalState) && (finalState->is_choice))
-                            {
-                                parse_choice_path(out, finalState);
-                            }
-                            else
-                            {
-                                out << get_indent() << "state = " << styler.get_state_name(finalState) << ";"
-                                    << std::endl;
-                            }
-                            decrease_indent();
+    out << get_indent() << "static const char* const state_names[] = {" << std::endl;
+    increase_indent();
+    for (auto state : states)
+    {
+        out << get_indent() << "\"" << escape(state->name) << "\"," << std::endl;
+    }
+    decrease_indent();
+    out << get_indent() << "};" << std::endl;
+    if (!transitions.empty())
+    {
+        out << get_indent() << "static const char* const transition_names[] = {" << std::endl;
+        increase_indent();
+        for (auto tr : transitions)
+        {
+            out << get_indent() << "\"" << escape(Profile::get_transition_key(reader, tr)) << "\"," << std::endl;
+        }
+        decrease_indent();
+        out << get_indent() << "};" << std::endl;
+    }
+    out << std::endl;
 
-                            out << get_indent() << "}" << std::endl;
-                        }
-                    }
-                }
+    out << get_indent() << "std::string profile {};" << std::endl;
+    out << get_indent() << "for (size_t i = 0; i < " << states.size() << "; i++)" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
 
-                out << get_indent() << "else" << std::endl;
-                out << get_indent() << "{" << std::endl;
-                increase_indent();
+    out << get_indent() << "profile += std::to_string(profile_states[i]) + \" state \" + state_names[i] + \"\\n\";"
+        << std::endl;
+    decrease_indent();
 
-                out << get_indent() << "did_transition = false;" << std::endl;
-                decrease_indent();
+    out << get_indent() << "}" << std::endl;
+    if (!transitions.empty())
+    {
+        out << get_indent() << "for (size_t i = 0; i < " << transitions.size() << "; i++)" << std::endl;
+        out << get_indent() << "{" << std::endl;
+        increase_indent();
 
-                out << get_indent() << "}" << std::endl;
-            }
+        out << get_indent()
+            << "profile += std::to_string(profile_transitions[i]) + \" transition \" + transition_names[i] + \"\\n\";"
+            << std::endl;
+        decrease_indent();
 
-            while (startIndent + 1 < indent)
-            {
-                decrease_indent();
-                out << get_indent() << "}" << std::endl;
-            }
+        out << get_indent() << "}" << std::endl;
+    }
+    out << get_indent() << "return profile;" << std::endl;
+    decrease_indent();
 
-            out << get_indent() << "return did_transition;" << std::endl;
-            decrease_indent();
+    out << get_indent() << "}" << std::endl << std::endl;
+}
 
-            out << get_indent() << "}" << std::endl << std::endl;
-        }
-    }
+void Writer::write_profile_macros(std::ostream& out)
+{
+    // the branch hints need C++20, the function hints a compiler that knows the gnu attributes.
+    out << "#ifndef PLANTGEN_LIKELY" << std::endl;
+    out << "#if (__cplusplus >= 202002L)" << std::endl;
+    out << "#define PLANTGEN_LIKELY [[likely]]" << std::endl;
+    out << "#define PLANTGEN_UNLIKELY [[unlikely]]" << std::endl;
+    out << "#else" << std::endl;
+    out << "#define PLANTGEN_LIKELY" << std::endl;
+    out << "#define PLANTGEN_UNLIKELY" << std::endl;
+    out << "#endif" << std::endl;
+    out << "#endif" << std::endl << std::endl;
+
+    out << "#ifndef PLANTGEN_HOT" << std::endl;
+    out << "#if defined(__GNUC__) || defined(__clang__)" << std::endl;
+    out << "#define PLANTGEN_HOT [[gnu::hot]]" << std::endl;
+    out << "#define PLANTGEN_COLD [[gnu::cold]]" << std::endl;
+    out << "#else" << std::endl;
+    out << "#define PLANTGEN_HOT" << std::endl;
+    out << "#define PLANTGEN_COLD" << std::endl;
+    out << "#endif" << std::endl;
+    out << "#endif" << std::endl << std::endl;
 }
 
-void Writer::impl_entry_action(std::ofstream& out)
+std::vector<State*> Writer::get_enum_states()
 {
+    std::vector<State*> states {};
     for (auto i = 0u; i < reader.getStateCount(); i++)
     {
         auto state = reader.getState(i);
-        if ("initial" != state->name)
+        if (("initial" != state->name) && ("final" != state->name) && !state->is_choice)
         {
-            const auto numDecl   = reader.getDeclCount(state->id, Declaration::Entry);
-            size_t     numTimeEv = 0;
-            for (auto j = 0u; j < reader.getTransitionCountFromStateId(state->id); j++)
-            {
-                auto tr = reader.getTransitionFrom(state->id, j);
-                if ((nullptr != tr) && (tr->event.is_time_event))
-                {
-                    numTimeEv++;
-                }
-            }
-
-            if ((0 < numDecl) || (0 < numTimeEv))
-            {
-                out << get_indent() << "void " << reader.get_model_name() << "::" << styler.get_state_entry(state)
-                    << "()" << std::endl;
-                out << get_indent() << "{" << std::endl;
+            states.push_back(state);
+        }
+    }
+    return states;
+}
 
-                // start timers
-                size_t writeIndex = 0;
-                increase_indent();
+std::vector<Transition*> Writer::get_profiled_transitions()
+{
+    // only transitions taken on an event, initial and choice transitions are followed from those.
+    std::vector<Transition*> transitions {};
+    for (auto i = 0u; i < reader.getTransitionCount(); i++)
+    {
+        auto tr     = reader.getTransition(i);
+        auto source = reader.getStateById(tr->state_a);
+        if ((nullptr != source) && ("initial" != source->name) && !source->is_choice && ("null" != tr->event.name))
+        {
+            transitions.push_back(tr);
+        }
+    }
+    return transitions;
+}
 
-                for (auto j = 0u; j < reader.getTransitionCountFromStateId(state->id); j++)
-                {
-                    auto tr = reader.getTransitionFrom(state->id, j);
-                    if ((nullptr != tr) && (tr->event.is_time_event))
-                    {
-                        out << get_indent() << "/* Start timer " << Style::get_event_name(&tr->event)
-                            << " with timeout of " << tr->event.expire_time_ms << " ms. */" << std::endl;
-                        out << get_indent() << "time_events." << Style::get_event_name(&tr->event)
-                            << ".timeout_ms = " << tr->event.expire_time_ms << ";" << std::endl;
-                        out << get_indent() << "time_events." << Style::get_event_name(&tr->event)
-                            << ".expire_time_ms = time_now_ms + " << tr->event.expire_time_ms << ";" << std::endl;
-                        out << get_indent() << "time_events." << Style::get_event_name(&tr->event)
-                            << ".is_periodic = " << (tr->event.is_periodic ? "true;" : "false;") << std::endl;
-                        out << get_indent() << "time_events." << Style::get_event_name(&tr->event)
-                            << ".is_started = true;" << std::endl;
-                        writeIndex++;
-                        if (writeIndex < numTimeEv)
-                        {
-                            out << std::endl;
-                        }
-                    }
-                }
+size_t Writer::get_profile_index(const Transition* tr)
+{
+    const auto transitions = get_profiled_transitions();
+    return static_cast<size_t>(std::find(transitions.begin(), transitions.end(), tr) - transitions.begin());
+}
 
-                if ((0 < numDecl) && (0 < numTimeEv))
-                {
-                    // add a space between the parts
-                    out << std::endl;
-                }
+std::vector<Transition*> Writer::get_transition_order(const State* state)
+{
+    std::vector<Transition*> transitions {};
+    bool                     hasNullTransition = false;
+    for (auto j = 0u; j < reader.getTransitionCountFromStateId(state->id); j++)
+    {
+        auto tr = reader.getTransitionFrom(state->id, j);
+        hasNullTransition = hasNullTransition || ("null" == tr->event.name);
+        transitions.push_back(tr);
+    }
+    if (!profile.has_data() || hasNullTransition)
+    {
+        return transitions;
+    }
 
-                for (auto j = 0u; j < numDecl; j++)
-                {
-                    auto decl = reader.getDeclFromStateId(state->id, Declaration::Entry, j);
-                    if (Declaration::Entry == decl->type)
-                    {
-                        parse_declaration(out, decl->declaration);
-                    }
-                }
-                decrease_indent();
+    // only one event matches, so events may be checked in any order, but guards on the same event keep theirs.
+    std::map<std::string, size_t> counts {};
+    for (auto tr : transitions)
+    {
+        counts[tr->event.name] += profile.get_transition_count(Profile::get_transition_key(reader, tr));
+    }
+    std::stable_sort(transitions.begin(),
+                     transitions.end(),
+                     [&counts](const Transition* a, const Transition* b)
+                     {
+                         return counts[a->event.name] > counts[b->event.name];
+                     });
+    return transitions;
+}
 
-                out << get_indent() << "}" << std::endl << std::endl;
-            }
+std::vector<State*> Writer::get_definition_order()
+{
+    std::vector<State*> states {};
+    for (auto i = 0u; i < reader.getStateCount(); i++)
+    {
+        states.push_back(reader.getState(i));
+    }
+    if (profile.has_data())
+    {
+        // hot code first, so that it ends up close together.
+        std::map<StateId, size_t> activity {};
+        for (auto state : states)
+        {
+            activity[state->id] = get_activity(state);
         }
+        std::stable_sort(states.begin(),
+                         states.end(),
+                         [&activity](const State* a, const State* b)
+                         {
+                             return activity[a->id] > activity[b->id];
+                         });
     }
+    return states;
 }
 
-void Writer::impl_exit_action(std::ofstream& out)
+size_t Writer::get_activity(const State* state)
 {
+    // events dispatched while the state, or any state inside it, was active.
+    size_t count = 0;
     for (auto i = 0u; i < reader.getStateCount(); i++)
     {
-        auto state = reader.getState(i);
-        if ("initial" != state->name)
+        auto active = reader.getState(i);
+        for (auto s = active; nullptr != s; s = reader.getStateById(s->parent))
         {
-            const auto numDecl   = reader.getDeclCount(state->id, Declaration::Exit);
-            size_t     numTimeEv = 0;
-            for (auto j = 0u; j < reader.getTransitionCountFromStateId(state->id); j++)
+            if (state->id == s->id)
             {
-                auto tr = reader.getTransitionFrom(state->id, j);
-                if ((nullptr != tr) && (tr->event.is_time_event))
-                {
-                    numTimeEv++;
-                }
+                count += profile.get_state_count(active->name);
+                break;
             }
+        }
+    }
+    return count;
+}
 
-            if ((0 < numDecl) || (0 < numTimeEv))
-            {
-                out << get_indent() << "void " << reader.get_model_name() << "::" << styler.get_state_exit(state)
-                    << "()" << std::endl;
-                out << get_indent() << "{" << std::endl;
-
-                // stop timers
-                increase_indent();
-                for (auto j = 0u; j < reader.getTransitionCountFromStateId(state->id); j++)
-                {
-                    auto tr = reader.getTransitionFrom(state->id, j);
-                    if ((nullptr != tr) && (tr->event.is_time_event))
-                    {
-                        out << get_indent() << "time_events." << Style::get_event_name(&tr->event)
-                            << ".is_started = false;" << std::endl;
-                    }
-                }
+std::string Writer::get_branch_hint(const Transition* tr)
+{
+    if (!profile.has_data())
+    {
+        return "";
+    }
 
-                if ((0 < numDecl) && (0 < numTimeEv))
-                {
-                    // add a space between the parts
-                    out << std::endl;
-                }
+    const auto evaluated = get_activity(reader.getStateById(tr->state_a));
+    const auto taken     = profile.get_transition_count(Profile::get_transition_key(reader, tr));
+    if (0 == evaluated)
+    {
+        // nothing known about this state.
+        return "";
+    }
+    if (evaluated < (2 * taken))
+    {
+        return " PLANTGEN_LIKELY";
+    }
+    if ((20 * taken) < evaluated)
+    {
+        return " PLANTGEN_UNLIKELY";
+    }
+    return "";
+}
 
-                if (0 < numDecl)
-                {
-                    for (auto j = 0u; j < numDecl; j++)
-                    {
-                        auto decl = reader.getDeclFromStateId(state->id, Declaration::Exit, j);
-                        if (Declaration::Exit == decl->type)
-                        {
-                            parse_declaration(out, decl->declaration);
-                        }
-                    }
-                }
-                decrease_indent();
+std::string Writer::get_function_hint(const SharedFunctions& functions, const State* state)
+{
+    if (!profile.has_data())
+    {
+        return "";
+    }
 
-                out << get_indent() << "}" << std::endl << std::endl;
-            }
+    size_t total = 0;
+    for (auto s : get_enum_states())
+    {
+        total += profile.get_state_count(s->name);
+    }
+    size_t activity = 0;
+    for (const auto& owner : functions.owners)
+    {
+        if (state->id == owner.second)
+        {
+            activity += get_activity(reader.getStateById(owner.first));
         }
     }
+
+    // hot when active for at least a tenth of all events, cold when never active.
+    if (0 == total)
+    {
+        return "";
+    }
+    if (0 == activity)
+    {
+        return "PLANTGEN_COLD ";
+    }
+    if (total <= (10 * activity))
+    {
+        return "PLANTGEN_HOT ";
+    }
+    return "";
 }
 
 std::vector<std::string> Writer::tokenize(const std::string& str)
@@ -1472,7 +5229,7 @@ std::vector<std::string> Writer::tokenize(const std::string& str)
     return (tokens);
 }
 
-void Writer::parse_declaration(std::ofstream& out, const std::string& declaration)
+void Writer::parse_declaration(std::ostream& out, const std::string& declaration)
 {
     // replace all X that corresponds with an event name with handle->events.X.param
     // also replace any word found that corresponds to a variable to its
@@ -1686,7 +5443,7 @@ std::string Writer::parse_guard(const std::string& guardStrRaw)
                         {
                             wstr += "exported.";
                         }
-                        wstr += var->name;
+                        wstr += Style::get_variable_name(var);
                         isReplaced = true;
                         break;
                     }
@@ -1699,7 +5456,7 @@ std::string Writer::parse_guard(const std::string& guardStrRaw)
                         auto ev = reader.getInEvent(i);
                         if (replaceString == ev->name)
                         {
-                            wstr += "events.inEvents." + ev->name + ".param";
+                            wstr += "event.parameter.in_" + Style::get_event_name(ev);
                             isReplaced = true;
                             break;
                         }
@@ -1719,7 +5476,7 @@ std::string Writer::parse_guard(const std::string& guardStrRaw)
     return (wstr);
 }
 
-void Writer::parse_choice_path(std::ofstream& out, State* state)
+void Writer::parse_choice_path(std::ostream& out, State* state)
 {
     // check all transitions from the choice..
     out << std::endl << get_indent() << "/* Choice: " << state->name << " */" << std::endl;
@@ -1744,7 +5501,7 @@ void Writer::parse_choice_path(std::ofstream& out, State* state)
             else
             {
                 // handle if statement
-                out << get_indent() << get_if_else_if(k++) << " (" << parse_guard(tr->guard) << ")" << std::endl;
+                out << get_indent() << get_if_else_if(k++) << " (" << get_guard_check(tr) << ")" << std::endl;
                 out << get_indent() << "{" << std::endl;
                 increase_indent();
 
@@ -1774,7 +5531,7 @@ void Writer::parse_choice_path(std::ofstream& out, State* state)
 
                         if (0 < reader.getDeclCount(finalState->id, Declaration::Entry))
                         {
-                            out << get_indent() << styler.get_state_entry(finalState) << "();" << std::endl;
+                            out << get_indent() << get_entry_function(finalState) << "();" << std::endl;
                         }
                     }
                     if (nullptr != finalState)
@@ -1827,7 +5584,7 @@ void Writer::parse_choice_path(std::ofstream& out, State* state)
 
                     if (0 < reader.getDeclCount(finalState->id, Declaration::Entry))
                     {
-                        out << get_indent() << styler.get_state_entry(finalState) << "();" << std::endl;
+                        out << get_indent() << get_entry_function(finalState) << "();" << std::endl;
                     }
                 }
                 if (nullptr != finalState)
@@ -1870,7 +5627,7 @@ std::vector<State*> Writer::get_child_states(State* currentState)
     return (childStates);
 }
 
-bool Writer::parse_child_exits(std::ofstream& out, State* currentState, StateId topState, bool didPreviousWrite)
+bool Writer::parse_child_exits(std::ostream& out, State* currentState, StateId topState, bool didPreviousWrite)
 {
     bool didWrite = didPreviousWrite;
 
@@ -1906,10 +5663,10 @@ bool Writer::parse_child_exits(std::ofstream& out, State* currentState, StateId
 
             if (has_exit_statement(currentState->id))
             {
-                out << get_indent() << styler.get_state_exit(currentState) << "();" << std::endl;
+                out << get_indent() << get_exit_function(currentState) << "();" << std::endl;
             }
 
-            if (config.do_tracing)
+            if (uses_state_trace())
             {
                 out << get_indent() << get_trace_call_exit(currentState) << std::endl;
             }
@@ -1920,9 +5677,9 @@ bool Writer::parse_child_exits(std::ofstream& out, State* currentState, StateId
                 currentState = reader.getStateById(currentState->parent);
                 if (has_exit_statement(currentState->id))
                 {
-                    out << get_indent() << styler.get_state_exit(currentState) << "();" << std::endl;
+                    out << get_indent() << get_exit_function(currentState) << "();" << std::endl;
                 }
-                if (config.do_tracing)
+                if (uses_state_trace())
                 {
                     out << get_indent() << get_trace_call_exit(currentState) << std::endl;
                 }
@@ -1945,6 +5702,30 @@ bool Writer::parse_child_exits(std::ofstream& out, State* currentState, StateId
     return (didWrite);
 }
 
+bool Writer::has_leaf_without_exit(State* currentState, StateId topState)
+{
+    const auto children = get_child_states(currentState);
+    if (children.empty())
+    {
+        for (auto s = currentState; topState != s->id; s = reader.getStateById(s->parent))
+        {
+            if (has_exit_statement(s->id))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    for (auto child : children)
+    {
+        if (has_leaf_without_exit(child, topState))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool Writer::has_entry_statement(StateId stateId)
 {
     if (0u < reader.getDeclCount(stateId, Declaration::Entry))
@@ -2126,6 +5907,284 @@ std::vector<State*> Writer::find_init_state()
     return (states);
 }
 
+void Writer::write_runtime_include(std::ostream& out)
+{
+    out << get_indent() << "#include \"" << Runtime::get_filename() << "\"" << std::endl << std::endl;
+    out << get_indent() << "static_assert(PLANTGEN_RUNTIME_VERSION == " << Runtime::version << ", \""
+        << Runtime::get_filename() << " does not match the generated code, regenerate it.\");" << std::endl
+        << std::endl;
+}
+
+std::string Writer::get_queue_type(const std::string& type) const
+{
+    if ((0 < queue_capacity) && config.shared_runtime)
+    {
+        return Runtime::get_namespace() + "::EventRing<" + type + ", " + std::to_string(queue_capacity) + ">";
+    }
+    if (0 < queue_capacity)
+    {
+        return "EventRing<" + type + ", " + std::to_string(queue_capacity) + ">";
+    }
+    if (config.shared_runtime)
+    {
+        return Runtime::get_namespace() + "::EventQueue<" + type + ">";
+    }
+    return "std::deque<" + type + ">";
+}
+
+std::string Writer::get_ingress_type() const
+{
+    // the ingress indexes its cells with a mask, so the capacity is rounded up to a power of two.
+    size_t capacity = 1;
+    while (capacity < config.ingress_capacity)
+    {
+        capacity *= 2;
+    }
+    if (config.shared_runtime)
+    {
+        return Runtime::get_namespace() + "::EventIngress<Event, " + std::to_string(capacity) + ">";
+    }
+    return "EventIngress<Event, " + std::to_string(capacity) + ">";
+}
+
+std::string Writer::get_enum_base(const size_t count) const
+{
+    if (!config.compact_layout)
+    {
+        return "";
+    }
+    return (count <= 256) ? " : uint8_t" : " : uint16_t";
+}
+
+bool Writer::is_compact_timers()
+{
+    // more timers than bits in the widest integer keep a record for each timer.
+    return config.compact_layout && (reader.getTimeEventCount() <= 64);
+}
+
+std::string Writer::get_timer_bits_type()
+{
+    const auto n_time_events = reader.getTimeEventCount();
+    if (n_time_events <= 8)
+    {
+        return "uint8_t";
+    }
+    if (n_time_events <= 16)
+    {
+        return "uint16_t";
+    }
+    return (n_time_events <= 32) ? "uint32_t" : "uint64_t";
+}
+
+size_t Writer::get_timer_index(const Event* ev)
+{
+    for (auto i = 0u; i < reader.getTimeEventCount(); i++)
+    {
+        if (reader.getTimeEvent(i)->name == ev->name)
+        {
+            return i;
+        }
+    }
+    return 0;
+}
+
+bool Writer::uses_timer_service() const
+{
+    return config.timer_service && (0 < reader.getTimeEventCount());
+}
+
+std::string Writer::get_timer_mask(const Event* ev)
+{
+    const auto         bit = get_timer_index(ev);
+    std::ostringstream oss {};
+    oss << "0x" << std::hex << (uint64_t(1) << bit) << ((bit < 32) ? "u" : "ull");
+    return oss.str();
+}
+
+std::string Writer::get_timer_running(const Event* ev, const std::string& object)
+{
+    if (is_compact_timers())
+    {
+        return "0 != (" + object + "time_events.is_started & " + get_timer_mask(ev) + ")";
+    }
+    return object + "time_events." + Style::get_event_name(ev) + ".is_started";
+}
+
+std::string Writer::get_timer_expire(const Event* ev, const std::string& object)
+{
+    if (is_compact_timers())
+    {
+        return object + "time_events." + Style::get_event_name(ev);
+    }
+    return object + "time_events." + Style::get_event_name(ev) + ".expire_time_ms";
+}
+
+void Writer::impl_timer_cancel(std::ostream& out, const Event* ev)
+{
+    out << get_indent() << "if (" << get_timer_running(ev, "") << ")" << std::endl;
+    out << get_indent() << "{" << std::endl;
+    increase_indent();
+
+    out << get_indent() << "timer_service.cancel(this, " << get_timer_index(ev) << ", " << get_timer_expire(ev, "")
+        << ");" << std::endl;
+    decrease_indent();
+
+    out << get_indent() << "}" << std::endl;
+}
+
+void Writer::impl_timer_stop(std::ostream& out, const Event* ev)
+{
+    out << get_indent() << "time_events.is_started &= static_cast<" << get_timer_bits_type() << ">(~"
+        << get_timer_mask(ev) << ");" << std::endl;
+}
+
+std::string Writer::get_raise_in_type() const
+{
+    // only the raise functions of in events report a full queue, internal events are raised by the actions.
+    if ((0 < config.ingress_capacity) || ((0 < queue_capacity) && (QueueOverflow::ReturnFalse == queue_overflow)))
+    {
+        return "bool";
+    }
+    return "void";
+}
+
+std::string Writer::get_class_scope() const
+{
+    if (config.lean_header)
+    {
+        return reader.get_model_name() + "::Impl";
+    }
+    return reader.get_model_name();
+}
+
+std::string Writer::get_class_name() const
+{
+    if (config.lean_header)
+    {
+        return "Impl";
+    }
+    return reader.get_model_name();
+}
+
+std::vector<PublicFunction> Writer::get_public_functions()
+{
+    std::vector<PublicFunction> functions {};
+
+    if (config.do_tracing)
+    {
+        if (TraceHook::Pointer == config.trace_hook)
+        {
+            functions.emplace_back(
+                    "void", "set_trace_enter_callback", "TraceEntry_t enter_cb, void* context", "enter_cb, context");
+            functions.emplace_back(
+                    "void", "set_trace_exit_callback", "TraceExit_t exit_cb, void* context", "exit_cb, context");
+        }
+        else if (TraceHook::Function == config.trace_hook)
+        {
+            functions.emplace_back("void", "set_trace_enter_callback", "const TraceEntry_t& enter_cb", "enter_cb");
+            functions.emplace_back("void", "set_trace_exit_callback", "const TraceExit_t& exit_cb", "exit_cb");
+        }
+
+        PublicFunction get_state_name("std::string", "get_state_name", Style::get_state_type() + " s", "s");
+        get_state_name.is_static = true;
+        functions.push_back(get_state_name);
+
+        PublicFunction get_state(Style::get_state_type(), "get_state", "", "");
+        get_state.is_const     = true;
+        get_state.is_nodiscard = true;
+        functions.push_back(get_state);
+    }
+    if (config.trace_ring)
+    {
+        functions.emplace_back("void",
+                "set_trace_ring",
+                Runtime::get_namespace() + "::TraceRing* ring, uint16_t instance",
+                "ring, instance");
+    }
+    functions.emplace_back("void", "init", "", "");
+    if ((0 < reader.getTimeEventCount()) && !uses_timer_service())
+    {
+        functions.emplace_back("void", Style::get_time_tick(), "size_t time_elapsed_ms", "time_elapsed_ms");
+        if (config.tickless_timers)
+        {
+            PublicFunction next_timeout("size_t", "next_timeout_ms", "", "");
+            next_timeout.is_nodiscard = true;
+            functions.push_back(next_timeout);
+        }
+    }
+    for (auto i = 0u; i < reader.getInEventCount(); i++)
+    {
+        auto ev = reader.getInEvent(i);
+        if ((nullptr != ev) && ("null" != ev->name))
+        {
+            if (ev->require_parameter)
+            {
+                functions.emplace_back(
+                        get_raise_in_type(),
+                        Style::get_event_raise(ev),
+                        ev->parameter_type + " value",
+                        "value");
+            }
+            else
+            {
+                functions.emplace_back(get_raise_in_type(), Style::get_event_raise(ev), "", "");
+            }
+        }
+    }
+    if ((0 < config.ingress_capacity) && (0 < reader.getInEventCount()))
+    {
+        functions.emplace_back("size_t", "drain", "", "");
+    }
+    if (config.deferred_dispatch)
+    {
+        functions.emplace_back("size_t", "process", "size_t max_events", "max_events");
+        functions.emplace_back("size_t", "process_until", "std::chrono::steady_clock::time_point deadline", "deadline");
+    }
+    if (0 < reader.getOutEventCount())
+    {
+        functions.emplace_back("bool", "is_out_event_raised", reader.get_model_name() + "_OutEvent& ev", "ev");
+    }
+    if (config.instrument)
+    {
+        PublicFunction get_profile("std::string", "get_profile", "", "");
+        get_profile.is_const     = true;
+        get_profile.is_nodiscard = true;
+        functions.push_back(get_profile);
+    }
+    for (auto i = 0u; i < reader.get_variable_count(); i++)
+    {
+        auto var = reader.getPublicVariable(i);
+        if (nullptr != var)
+        {
+            PublicFunction getter(var->type, "get_" + Style::get_variable_name(var), "", "");
+            getter.is_const     = true;
+            getter.is_nodiscard = true;
+            functions.push_back(getter);
+        }
+    }
+
+    return (functions);
+}
+
+std::string Writer::get_prototype(const PublicFunction& fn)
+{
+    std::string s {};
+    if (fn.is_nodiscard)
+    {
+        s += "[[nodiscard]] ";
+    }
+    if (fn.is_static)
+    {
+        s += "static ";
+    }
+    s += fn.return_type + " " + fn.name + "(" + fn.parameters + ")";
+    if (fn.is_const)
+    {
+        s += " const";
+    }
+    return (s);
+}
+
 std::string Writer::get_indent() const
 {
     std::string s {};
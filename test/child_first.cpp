@@ -0,0 +1,65 @@
+/** @file
+ *  @brief Checks that the switch, flattened and table backends take the same transitions and trace the same states.
+ */
+
+#include "child_first_flatten.h"
+#include "child_first_switch.h"
+#include "child_first_table.h"
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+///\brief Runs one machine through the scenario, returning its trace and the state after each event.
+template <typename Machine, typename State>
+std::vector<std::string> run()
+{
+    std::vector<std::string> log {};
+    Machine                  machine {};
+    machine.set_trace_enter_callback([&](State s) { log.push_back("enter " + Machine::get_state_name(s)); });
+    machine.set_trace_exit_callback([&](State s) { log.push_back("exit " + Machine::get_state_name(s)); });
+    machine.init();
+
+    const auto step = [&](const std::string& event)
+    {
+        if ("go" == event)
+        {
+            machine.raise_go();
+        }
+        else
+        {
+            machine.raise_back();
+        }
+        log.push_back(event + " -> " + Machine::get_state_name(machine.get_state()));
+    };
+    // c1 handles go itself, c2 leaves the handling to P, whose exit is traced although c2 has no exit action.
+    for (const auto* event : { "go", "back", "back", "go", "back" })
+    {
+        step(event);
+    }
+    return log;
+}
+
+int main()
+{
+    const auto on_switch  = run<child_first_switch::child_first_switch, child_first_switch::State>();
+    const auto on_flatten = run<child_first_flatten::child_first_flatten, child_first_flatten::State>();
+    const auto on_table   = run<child_first_table::child_first_table, child_first_table::State>();
+
+    int failures = 0;
+    if ((on_switch != on_flatten) || (on_switch != on_table))
+    {
+        std::cout << "FAILED: the backends differ" << std::endl;
+        failures++;
+    }
+    if (on_switch.end() == std::find(on_switch.begin(), on_switch.end(), "go -> y"))
+    {
+        std::cout << "FAILED: with -c the transition of c1 on go is taken before the one of P" << std::endl;
+        failures++;
+    }
+    for (const auto& line : on_switch)
+    {
+        std::cout << line << std::endl;
+    }
+    return (0 == failures) ? 0 : 1;
+}
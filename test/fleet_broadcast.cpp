@@ -0,0 +1,95 @@
+/** @file
+ *  @brief Checks that a fleet broadcast leaves every instance as raising the event on each instance does.
+ */
+
+#include "broadcast.h"
+#include <iostream>
+#include <random>
+#include <vector>
+
+// not a multiple of any vector width, so that the scalar loop handles the last instances.
+constexpr size_t instances = 101;
+
+///\brief The out events of each instance, in the order they were raised.
+std::vector<std::vector<int>> take_hits(Broadcast::BroadcastFleet& fleet)
+{
+    std::vector<std::vector<int>> hits(instances);
+    size_t                        id = 0;
+    Broadcast::Broadcast_OutEvent ev {};
+    while (fleet.is_out_event_raised(id, ev))
+    {
+        hits[id].push_back(ev.parameter.hit);
+    }
+    return hits;
+}
+
+int main()
+{
+    Broadcast::BroadcastFleet broadcast {};
+    Broadcast::BroadcastFleet one_by_one {};
+    for (size_t i = 0; i < instances; i++)
+    {
+        broadcast.add();
+        one_by_one.add();
+    }
+
+    // the single raises spread the instances over all states, the broadcasts then find every kind of cell.
+    std::mt19937 rng(5);
+    int          failures = 0;
+    for (int step = 0; (step < 20000) && (0 == failures); step++)
+    {
+        const auto r  = rng() % 10;
+        const auto id = rng() % instances;
+        if (r < 3)
+        {
+            broadcast.broadcast_next();
+            for (size_t i = 0; i < instances; i++)
+            {
+                one_by_one.raise_next(i);
+            }
+        }
+        else if (r < 5)
+        {
+            broadcast.broadcast_back();
+            for (size_t i = 0; i < instances; i++)
+            {
+                one_by_one.raise_back(i);
+            }
+        }
+        else if (r < 6)
+        {
+            broadcast.broadcast_reset(3);
+            for (size_t i = 0; i < instances; i++)
+            {
+                one_by_one.raise_reset(i, 3);
+            }
+        }
+        else if (r < 8)
+        {
+            broadcast.raise_next(id);
+            one_by_one.raise_next(id);
+        }
+        else
+        {
+            broadcast.raise_back(id);
+            one_by_one.raise_back(id);
+        }
+
+        if (take_hits(broadcast) != take_hits(one_by_one))
+        {
+            std::cout << "FAILED: the out events differ at step " << step << std::endl;
+            failures++;
+        }
+        for (size_t i = 0; i < instances; i++)
+        {
+            if ((broadcast.get_state(i) != one_by_one.get_state(i))
+                || (broadcast.get_hits(i) != one_by_one.get_hits(i)))
+            {
+                std::cout << "FAILED: instance " << i << " differs at step " << step << std::endl;
+                failures++;
+                break;
+            }
+        }
+    }
+    return (0 == failures) ? 0 : 1;
+}
@@ -0,0 +1,83 @@
+/** @file
+ *  @brief Checks that a fleet snapshot restores the saved instances, and that a corrupt one is rejected.
+ */
+
+#include "snapshot.h"
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// the header of a snapshot is six 64 bit words, the states of the instances follow it.
+constexpr size_t header_size = 6 * sizeof(uint64_t);
+
+int failures = 0;
+
+void check(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        std::cout << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+std::vector<char> read_file(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+}
+
+void write_file(const std::string& path, const std::vector<char>& bytes)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+int main()
+{
+    Snapshot::SnapshotFleet saved {};
+    for (int i = 0; i < 5; i++)
+    {
+        saved.add();
+    }
+    saved.raise_go(1, 4);
+    saved.raise_go(3, 7);
+    saved.time_tick(500);
+    check(saved.save("fleet_snapshot.bin"), "the fleet is saved");
+
+    Snapshot::SnapshotFleet restored {};
+    check(restored.restore("fleet_snapshot.bin"), "the snapshot is restored");
+    check(5 == restored.size(), "every instance is restored");
+    check(2 == restored.count_in_state(Snapshot::State::busy), "the state index is rebuilt");
+    for (size_t id = 0; id < 5; id++)
+    {
+        check((saved.get_state(id) == restored.get_state(id)) && (saved.get_total(id) == restored.get_total(id)),
+              "each instance is restored as saved");
+    }
+    restored.time_tick(1500);
+    check(0 == restored.count_in_state(Snapshot::State::busy), "the timers continue from the saved time");
+
+    // an instance in a state the model does not have.
+    auto bytes = read_file("fleet_snapshot.bin");
+    check((header_size + (5 * sizeof(Snapshot::State))) < bytes.size(), "the snapshot holds the states");
+    bytes[header_size + (2 * sizeof(Snapshot::State))] = 0x7f;
+    write_file("fleet_snapshot_bad_state.bin", bytes);
+
+    Snapshot::SnapshotFleet other {};
+    other.add();
+    other.raise_go(0, 1);
+    check(!other.restore("fleet_snapshot_bad_state.bin"), "a state outside the model is rejected");
+    check(1 == other.size(), "a rejected snapshot keeps the instances");
+    check(Snapshot::State::busy == other.get_state(0), "a rejected snapshot keeps the states");
+    check(1 == other.count_in_state(Snapshot::State::busy), "a rejected snapshot keeps the state index");
+
+    bytes = read_file("fleet_snapshot.bin");
+    bytes.pop_back();
+    write_file("fleet_snapshot_truncated.bin", bytes);
+    check(!other.restore("fleet_snapshot_truncated.bin"), "a truncated snapshot is rejected");
+    check(1 == other.size(), "a truncated snapshot keeps the instances");
+
+    return (0 == failures) ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+/** @file
+ *  @brief Checks that the timer scan of a fleet expires the same timers as ticking each machine on its own.
+ */
+
+#include "timers.h"
+#include <iostream>
+#include <random>
+#include <vector>
+
+// not a multiple of any vector width, so that the scalar loop handles the last instances.
+constexpr size_t instances = 37;
+
+int main()
+{
+    Timers::TimersFleet         fleet {};
+    std::vector<Timers::Timers> machines(instances);
+    for (auto& machine : machines)
+    {
+        machine.init();
+        fleet.add();
+    }
+
+    // mostly short ticks, which expire few instances, and now and then one that passes every deadline.
+    std::mt19937 rng(11);
+    int          failures = 0;
+    for (int step = 0; (step < 50000) && (0 == failures); step++)
+    {
+        const auto r  = rng() % 10;
+        const auto id = rng() % instances;
+        if (r < 4)
+        {
+            const size_t elapsed_ms = (0 != (rng() % 3)) ? (rng() % 100) : (rng() % 20000000);
+            fleet.time_tick(elapsed_ms);
+            for (auto& machine : machines)
+            {
+                machine.time_tick(elapsed_ms);
+            }
+        }
+        else if (r < 7)
+        {
+            fleet.raise_go(id);
+            machines[id].raise_go();
+        }
+        else
+        {
+            fleet.raise_stop(id);
+            machines[id].raise_stop();
+        }
+
+        for (size_t i = 0; i < instances; i++)
+        {
+            if ((fleet.get_state(i) != machines[i].get_state()) || (fleet.get_fires(i) != machines[i].get_fires()))
+            {
+                std::cout << "FAILED: instance " << i << " differs at step " << step << std::endl;
+                failures++;
+                break;
+            }
+        }
+    }
+    return (0 == failures) ? 0 : 1;
+}
@@ -0,0 +1,71 @@
+/** @file
+ *  @brief Checks that the MPSC ingress dispatches the events of each producer thread in the order they were raised.
+ */
+
+#include "ingress.h"
+#include <iostream>
+#include <thread>
+#include <vector>
+
+constexpr int producers = 4;
+constexpr int per_producer = 20000;
+
+int main()
+{
+    Ingress::Ingress machine {};
+    machine.init();
+
+    std::vector<std::thread> threads {};
+    for (int p = 0; p < producers; p++)
+    {
+        threads.emplace_back(
+                [&machine, p]()
+                {
+                    for (int i = 0; i < per_producer; i++)
+                    {
+                        // the ingress is much smaller than the burst, so a full queue is retried.
+                        while (!machine.raise_put((p * per_producer) + i))
+                        {
+                            std::this_thread::yield();
+                        }
+                    }
+                });
+    }
+
+    int              failures = 0;
+    int              taken    = 0;
+    std::vector<int> next(producers, 0);
+    while (taken < (producers * per_producer))
+    {
+        if (0 == machine.drain())
+        {
+            std::this_thread::yield();
+        }
+        Ingress::Ingress_OutEvent ev {};
+        while (machine.is_out_event_raised(ev))
+        {
+            const auto value    = ev.parameter.taken;
+            const auto producer = value / per_producer;
+            if ((producer < 0) || (producer >= producers) || (next[producer] != (value % per_producer)))
+            {
+                if (failures < 10)
+                {
+                    std::cout << "FAILED: " << value << " is out of order" << std::endl;
+                }
+                failures++;
+            }
+            else
+            {
+                next[producer]++;
+            }
+            taken++;
+        }
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    std::cout << taken << " events taken from " << producers << " producers" << std::endl;
+    return (0 == failures) ? 0 : 1;
+}
@@ -0,0 +1,48 @@
+/** @file
+ *  @brief Checks that an out event of a submachine, on which the parent transitions, is queued by the machine.
+ */
+
+#include "connection.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+int failures = 0;
+
+void check(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        std::cout << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+int main()
+{
+    std::vector<std::string> log {};
+    Connection::Connection   machine {};
+    machine.set_trace_enter_callback([&](Connection::State s)
+                                     { log.push_back("enter " + Connection::Connection::get_state_name(s)); });
+    machine.set_trace_exit_callback([&](Connection::State s)
+                                    { log.push_back("exit " + Connection::Connection::get_state_name(s)); });
+    machine.init();
+
+    machine.raise_start();
+    machine.raise_fail();
+    check(Connection::State::connect_trying == machine.get_state(), "the first failure is retried");
+
+    // the entry action of failed raises gaveUp, which the parent handles once the transition is complete.
+    machine.raise_fail();
+    check(Connection::State::idle == machine.get_state(), "gaveUp leaves Connect");
+    check("enter idle" == log.back(), "idle is the last state entered");
+
+    machine.raise_start();
+    check(Connection::State::connect_trying == machine.get_state(), "Connect can be entered again");
+
+    for (const auto& line : log)
+    {
+        std::cout << line << std::endl;
+    }
+    return (0 == failures) ? 0 : 1;
+}
@@ -0,0 +1,53 @@
+/** @file
+ *  @brief Checks that machines generated with --timer-service leave no timers behind in the shared service.
+ */
+
+#include "pending.h"
+#include <iostream>
+#include <memory>
+#include <type_traits>
+
+// the service refers to the machine, which must therefore stay where it is.
+static_assert(!std::is_copy_constructible<Pending::Pending>::value, "a machine on the service can not be copied");
+static_assert(!std::is_move_constructible<Pending::Pending>::value, "a machine on the service can not be moved");
+
+int failures = 0;
+
+void check(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        std::cout << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+int main()
+{
+    plantgen::TimerService service {};
+
+    Pending::Pending stopped(service);
+    stopped.init();
+    stopped.raise_go();
+    check(1 == service.size(), "go schedules the timer");
+    stopped.raise_stop();
+    check(0 == service.size(), "leaving the state cancels the timer");
+
+    stopped.raise_go();
+    service.advance(2000);
+    check(Pending::State::idle == stopped.get_state(), "the timer fires at its deadline");
+    check(0 == service.size(), "a fired timer is not pending");
+
+    auto destroyed = std::make_unique<Pending::Pending>(service);
+    destroyed->init();
+    destroyed->raise_go();
+    check(1 == service.size(), "go schedules the timer of the second machine");
+    destroyed.reset();
+    check(0 == service.size(), "destroying a machine cancels its timers");
+
+    // would wake the destroyed machine if its timer was still pending.
+    service.advance(5000);
+    check(0 == service.size(), "advancing past the cancelled deadline");
+
+    return (0 == failures) ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+/** @file
+ *  @brief Checks that tracedump decodes a dumped TraceRing back into the steps the machine took.
+ */
+
+#include "traced.h"
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int failures = 0;
+
+///\brief Runs the machine through both outcomes of the guard and a timer, then dumps the ring to path.
+bool record(size_t capacity, const std::string& path)
+{
+    plantgen::TraceRing ring(capacity);
+    Traced::Traced      machine {};
+    machine.set_trace_ring(&ring, 3);
+    machine.init();
+    machine.raise_go();
+    machine.raise_stop();
+    machine.time_tick(100);
+    machine.raise_go();
+    machine.raise_stop();
+    return ring.dump(path.c_str());
+}
+
+///\brief The log written by tracedump, without the timestamps.
+std::vector<std::string> decode(const std::string& tracedump, const std::string& map, const std::string& path)
+{
+    std::vector<std::string> lines {};
+    const auto               command = tracedump + " -i " + path + " -m " + map;
+    auto                     pipe    = popen(command.c_str(), "r");
+    if (nullptr == pipe)
+    {
+        return lines;
+    }
+    std::string line {};
+    for (int c = fgetc(pipe); EOF != c; c = fgetc(pipe))
+    {
+        if ('\n' != c)
+        {
+            line += static_cast<char>(c);
+            continue;
+        }
+        const auto time = line.find(" us  ");
+        lines.push_back((std::string::npos == time) ? line : line.substr(time + 5));
+        line.clear();
+    }
+    pclose(pipe);
+    return lines;
+}
+
+void check(const std::vector<std::string>& decoded, const std::vector<std::string>& expected, const char* what)
+{
+    if (decoded != expected)
+    {
+        std::cout << "FAILED: " << what << std::endl;
+        for (const auto& line : decoded)
+        {
+            std::cout << line << std::endl;
+        }
+        failures++;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (3 != argc)
+    {
+        std::cout << "usage: trace_ring_test <tracedump> <traced.trace.map>" << std::endl;
+        return 1;
+    }
+
+    const std::vector<std::string> expected {
+        "Traced#3  enter  idle",
+        "Traced#3  event  in_go",
+        "Traced#3  transition  idle -> busy : go",
+        "Traced#3  exit  idle",
+        "Traced#3  enter  busy",
+        "Traced#3  event  in_stop",
+        "Traced#3  guard failed  busy -> idle : stop [${runs} > 1]",
+        "Traced#3  timer  busy_after_100ms",
+        "Traced#3  event  time_busy_after_100ms",
+        "Traced#3  transition  busy -> idle : busy_after_100ms",
+        "Traced#3  exit  busy",
+        "Traced#3  enter  idle",
+        "Traced#3  event  in_go",
+        "Traced#3  transition  idle -> busy : go",
+        "Traced#3  exit  idle",
+        "Traced#3  enter  busy",
+        "Traced#3  event  in_stop",
+        "Traced#3  guard passed  busy -> idle : stop [${runs} > 1]",
+        "Traced#3  transition  busy -> idle : stop [${runs} > 1]",
+        "Traced#3  exit  busy",
+        "Traced#3  enter  idle",
+    };
+
+    if (!record(64, "trace_ring.bin") || !record(8, "trace_ring_wrapped.bin"))
+    {
+        std::cout << "FAILED: the rings are dumped" << std::endl;
+        return 1;
+    }
+    check(decode(argv[1], argv[2], "trace_ring.bin"), expected, "every record is decoded in order");
+
+    // a full ring keeps the newest records, still oldest first.
+    check(decode(argv[1], argv[2], "trace_ring_wrapped.bin"),
+          std::vector<std::string>(expected.end() - 8, expected.end()),
+          "a wrapped ring is decoded from its oldest record");
+
+    return (0 == failures) ? 0 : 1;
+}